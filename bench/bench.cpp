@@ -0,0 +1,334 @@
+#include <boost/program_options.hpp>
+#include <nlohmann/json.hpp>
+#include "LNS.h"
+#include "CBS.h"
+#include "AnytimeBCBS.h"
+#include "AnytimeEECBS.h"
+
+// Micro and macro benchmarks. Every measurement is printed as one JSON object per line.
+
+using json = nlohmann::json;
+
+// exposes the protected heuristic computation
+class HeuristicBench : public SIPP
+{
+public:
+    HeuristicBench(const Instance& instance, int agent) : SIPP(instance, agent) {}
+    void recompute() { my_heuristic.clear(); compute_heuristics(); }
+};
+
+// exposes the protected conflict detection of the root CT node
+class ConflictBench : public CBS
+{
+public:
+    ConflictBench(vector<SingleAgentSolver*>& search_engines) : CBS(search_engines, 0, nullptr) {}
+    size_t detect(vector<Path>& solution)
+    {
+        paths.resize(solution.size());
+        for (size_t i = 0; i < solution.size(); i++)
+            paths[i] = &solution[i];
+        CBSNode root;
+        root.parent = nullptr;
+        root.HLNode::parent = nullptr;
+        findConflicts(root);
+        return root.unknownConf.size();
+    }
+};
+
+static double areaUnderCurve(const list<IterationStats>& iteration_stats, int sum_of_distances, double time_limit)
+{
+    double auc = 0;
+    if (iteration_stats.empty())
+        return auc;
+    auto prev = iteration_stats.begin();
+    auto curr = prev;
+    ++curr;
+    while (curr != iteration_stats.end() && curr->runtime < time_limit)
+    {
+        auc += (prev->sum_of_costs - sum_of_distances) * (curr->runtime - prev->runtime);
+        prev = curr;
+        ++curr;
+    }
+    auc += (prev->sum_of_costs - sum_of_distances) * (time_limit - prev->runtime);
+    return auc;
+}
+
+static void report(std::ostream& out, json record)
+{
+    out << record.dump() << endl;
+}
+
+// plans the agents one by one with the given single-agent solvers, as PP does
+static vector<Path> runPrioritizedPlanning(const Instance& instance, vector<SingleAgentSolver*>& solvers,
+                                           bool avoid_others, double& seconds, uint64_t& expanded)
+{
+    PathTable path_table(instance.map_size);
+    vector<Path> paths(solvers.size());
+    seconds = 0;
+    expanded = 0;
+    for (size_t i = 0; i < solvers.size(); i++)
+    {
+        ConstraintTable constraint_table(instance.num_of_cols, instance.map_size,
+                                         avoid_others ? &path_table : nullptr);
+        auto start = Time::now();
+        paths[i] = solvers[i]->findPath(constraint_table);
+        seconds += ((fsec)(Time::now() - start)).count();
+        expanded += solvers[i]->getNumExpanded();
+        if (avoid_others && !paths[i].empty())
+            path_table.insertPath((int)i, paths[i]);
+    }
+    return paths;
+}
+
+static void runMicroBenchmarks(const Instance& instance, const string& instance_name, int repeats, std::ostream& out)
+{
+    int num_of_agents = instance.getDefaultNumberOfAgents();
+    json base = {{"kind", "micro"}, {"instance", instance_name}, {"agents", num_of_agents}};
+
+    // compute_heuristics
+    vector<HeuristicBench*> heuristic_solvers;
+    for (int i = 0; i < num_of_agents; i++)
+        heuristic_solvers.push_back(new HeuristicBench(instance, i));
+    auto start = Time::now();
+    for (int r = 0; r < repeats; r++)
+        for (auto solver : heuristic_solvers)
+            solver->recompute();
+    double seconds = ((fsec)(Time::now() - start)).count();
+    json record = base;
+    record["benchmark"] = "SingleAgentSolver::compute_heuristics";
+    record["calls"] = repeats * num_of_agents;
+    record["seconds"] = seconds;
+    record["calls_per_sec"] = repeats * num_of_agents / seconds;
+    report(out, record);
+    for (auto solver : heuristic_solvers)
+        delete solver;
+
+    // SIPP::findPath and SpaceTimeAStar::findPath, planning the agents in turn
+    vector<SingleAgentSolver*> sipp, astar;
+    for (int i = 0; i < num_of_agents; i++)
+    {
+        sipp.push_back(new SIPP(instance, i));
+        astar.push_back(new SpaceTimeAStar(instance, i));
+    }
+    vector<Path> planned_paths, independent_paths;
+    for (auto& solvers : {make_pair(string("SIPP::findPath"), &sipp), make_pair(string("SpaceTimeAStar::findPath"), &astar)})
+    {
+        double total_seconds = 0;
+        uint64_t total_expanded = 0;
+        for (int r = 0; r < repeats; r++)
+        {
+            uint64_t expanded;
+            planned_paths = runPrioritizedPlanning(instance, *solvers.second, true, seconds, expanded);
+            total_seconds += seconds;
+            total_expanded += expanded;
+        }
+        record = base;
+        record["benchmark"] = solvers.first;
+        record["calls"] = repeats * num_of_agents;
+        record["seconds"] = total_seconds;
+        record["calls_per_sec"] = repeats * num_of_agents / total_seconds;
+        record["expansions_per_sec"] = total_expanded / total_seconds;
+        report(out, record);
+    }
+    uint64_t expanded;
+    independent_paths = runPrioritizedPlanning(instance, sipp, false, seconds, expanded);
+
+    // PathTable::insertPath and PathTable::deletePath
+    PathTable path_table(instance.map_size);
+    double insert_seconds = 0, delete_seconds = 0;
+    for (int r = 0; r < repeats * 10; r++)
+    {
+        start = Time::now();
+        for (int i = 0; i < num_of_agents; i++)
+            path_table.insertPath(i, planned_paths[i]);
+        insert_seconds += ((fsec)(Time::now() - start)).count();
+        start = Time::now();
+        for (int i = 0; i < num_of_agents; i++)
+            path_table.deletePath(i, planned_paths[i]);
+        delete_seconds += ((fsec)(Time::now() - start)).count();
+    }
+    for (auto& measurement : {make_pair(string("PathTable::insertPath"), insert_seconds),
+                              make_pair(string("PathTable::deletePath"), delete_seconds)})
+    {
+        record = base;
+        record["benchmark"] = measurement.first;
+        record["calls"] = repeats * 10 * num_of_agents;
+        record["seconds"] = measurement.second;
+        record["calls_per_sec"] = repeats * 10 * num_of_agents / measurement.second;
+        report(out, record);
+    }
+
+    // CBS::findConflicts on the root node, using individually shortest paths
+    {
+        ConflictBench cbs(sipp);
+        size_t num_of_conflicts = 0;
+        start = Time::now();
+        for (int r = 0; r < repeats; r++)
+            num_of_conflicts = cbs.detect(independent_paths);
+        seconds = ((fsec)(Time::now() - start)).count();
+        record = base;
+        record["benchmark"] = "CBS::findConflicts";
+        record["calls"] = repeats;
+        record["conflicts"] = num_of_conflicts;
+        record["seconds"] = seconds;
+        record["calls_per_sec"] = repeats / seconds;
+        report(out, record);
+    }
+
+    // MDD::buildMDD, minimal MDDs without constraints
+    seconds = 0;
+    for (int r = 0; r < repeats; r++)
+    {
+        for (int i = 0; i < num_of_agents; i++)
+        {
+            ConstraintTable constraint_table(instance.num_of_cols, instance.map_size);
+            MDD mdd;
+            start = Time::now();
+            mdd.buildMDD(constraint_table, sipp[i]);
+            seconds += ((fsec)(Time::now() - start)).count();
+        }
+    }
+    record = base;
+    record["benchmark"] = "MDD::buildMDD";
+    record["calls"] = repeats * num_of_agents;
+    record["seconds"] = seconds;
+    record["calls_per_sec"] = repeats * num_of_agents / seconds;
+    report(out, record);
+
+    for (int i = 0; i < num_of_agents; i++)
+    {
+        delete sipp[i];
+        delete astar[i];
+    }
+}
+
+static void runMacroBenchmarks(const Instance& instance, const string& instance_name, double time_limit, int seed,
+                               std::ostream& out)
+{
+    json base = {{"kind", "macro"}, {"instance", instance_name},
+                 {"agents", instance.getDefaultNumberOfAgents()}, {"time_limit", time_limit}, {"seed", seed}};
+
+    { // LNS with the default settings of the driver
+        PIBTPPS_option pipp_option;
+        pipp_option.windowSize = 5;
+        pipp_option.winPIBTSoft = true;
+        pipp_option.timestepLimit = 0;
+        const string bandit_algorithm = "Random";
+        threadRandomEngine().seed(seed);
+        LNS lns(instance, time_limit, "PP", "PP", "bandit", 0, 0, true, "Adaptive", true, 0,
+                pipp_option, bandit_algorithm, 5);
+        lns.setSeed(seed);
+        lns.uniform_neighbor = 3;
+        bool succ = lns.run();
+        uint64_t expanded = 0;
+        for (auto& agent : lns.agents)
+        {
+            agent.path_planner->reset();
+            expanded += agent.path_planner->accumulated_num_expanded;
+        }
+        json record = base;
+        record["benchmark"] = "LNS";
+        record["success"] = succ;
+        record["runtime"] = lns.runtime;
+        record["iterations"] = lns.iteration_stats.size();
+        record["iterations_per_sec"] = lns.iteration_stats.size() / lns.runtime;
+        record["expansions_per_sec"] = expanded / lns.runtime;
+        record["time_to_first_solution"] = lns.initial_solution_runtime;
+        record["initial_cost"] = lns.initial_sum_of_costs;
+        record["final_cost"] = lns.sum_of_costs;
+        record["auc"] = areaUnderCurve(lns.iteration_stats, lns.sum_of_distances, time_limit);
+        report(out, record);
+    }
+    { // anytime BCBS
+        threadRandomEngine().seed(seed);
+        AnytimeBCBS bcbs(instance, time_limit, 0);
+        bcbs.run();
+        json record = base;
+        record["benchmark"] = "A-BCBS";
+        record["success"] = !bcbs.iteration_stats.empty() && bcbs.sum_of_costs < MAX_COST;
+        record["runtime"] = bcbs.runtime;
+        record["iterations"] = bcbs.iteration_stats.size();
+        record["iterations_per_sec"] = bcbs.iteration_stats.size() / bcbs.runtime;
+        record["time_to_first_solution"] = bcbs.iteration_stats.empty() ? -1 : bcbs.iteration_stats.front().runtime;
+        record["final_cost"] = bcbs.sum_of_costs;
+        record["auc"] = areaUnderCurve(bcbs.iteration_stats, bcbs.sum_of_distances, time_limit);
+        report(out, record);
+    }
+    { // anytime EECBS
+        threadRandomEngine().seed(seed);
+        AnytimeEECBS eecbs(instance, time_limit, 0);
+        eecbs.run();
+        json record = base;
+        record["benchmark"] = "A-EECBS";
+        record["success"] = !eecbs.iteration_stats.empty() && eecbs.sum_of_costs < MAX_COST;
+        record["runtime"] = eecbs.runtime;
+        record["iterations"] = eecbs.iteration_stats.size();
+        record["iterations_per_sec"] = eecbs.iteration_stats.size() / eecbs.runtime;
+        record["time_to_first_solution"] = eecbs.iteration_stats.empty() ? -1 : eecbs.iteration_stats.front().runtime;
+        record["final_cost"] = eecbs.sum_of_costs;
+        record["auc"] = areaUnderCurve(eecbs.iteration_stats, eecbs.sum_of_distances, time_limit);
+        report(out, record);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    namespace po = boost::program_options;
+    po::options_description desc("Allowed options");
+    desc.add_options()
+        ("help", "produce help message")
+        ("map,m", po::value<string>()->default_value(string(BENCH_DATA_DIR) + "/random-32-32-20.map"),
+                "bundled map file")
+        ("agents,a", po::value<string>()->default_value(string(BENCH_DATA_DIR) + "/random-32-32-20-random-1.scen"),
+                "bundled agent file")
+        ("agentNum,k", po::value<int>()->default_value(150), "number of agents")
+        ("generatedSize", po::value<int>()->default_value(64),
+                "rows and columns of the generated random map (0: skip the generated instance)")
+        ("generatedAgentNum", po::value<int>()->default_value(200), "number of agents on the generated map")
+        ("cutoffTime,t", po::value<double>()->default_value(5), "cutoff time of each macro run (seconds)")
+        ("repeats", po::value<int>()->default_value(5), "repetitions of each micro benchmark")
+        ("suite", po::value<string>()->default_value("all"), "benchmarks to run (micro, macro, all)")
+        ("seed", po::value<int>()->default_value(0), "Random seed")
+        ("output,o", po::value<string>()->default_value("bench.jsonl"),
+                "output file for the JSON lines (the solvers keep logging to stdout)")
+        ;
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    if (vm.count("help")) {
+        cout << desc << endl;
+        return 1;
+    }
+    po::notify(vm);
+
+    int seed = vm["seed"].as<int>();
+    string suite = vm["suite"].as<string>();
+    if (suite != "micro" && suite != "macro" && suite != "all")
+    {
+        cerr << "Benchmark suite " << suite << " does not exist!" << endl;
+        exit(-1);
+    }
+    ofstream out(vm["output"].as<string>());
+
+    threadRandomEngine().seed(seed);
+    vector<pair<string, Instance*>> instances;
+    instances.emplace_back("random-32-32-20", new Instance(vm["map"].as<string>(), vm["agents"].as<string>(), "",
+                                                           vm["agentNum"].as<int>()));
+    int size = vm["generatedSize"].as<int>();
+    if (size > 0) // a connected random grid with 20% obstacles, saved next to the binary and reused afterwards
+    {
+        string name = "bench-random-" + std::to_string(size) + "-" + std::to_string(size) + "-20";
+        instances.emplace_back(name, new Instance(name + ".map", name + ".scen", "",
+                                                  vm["generatedAgentNum"].as<int>(), size, size, size * size / 5));
+    }
+
+    for (auto& instance : instances)
+    {
+        if (suite != "macro")
+            runMicroBenchmarks(*instance.second, instance.first, vm["repeats"].as<int>(), out);
+        if (suite != "micro")
+            runMacroBenchmarks(*instance.second, instance.first, vm["cutoffTime"].as<double>(), seed, out);
+        delete instance.second;
+    }
+    cout << "Benchmark results written to " << vm["output"].as<string>() << endl;
+    return 0;
+}
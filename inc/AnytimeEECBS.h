@@ -1,11 +1,12 @@
 #pragma once
 #include "Instance.h"
+#include "CompactPath.h"
 
 
 class AnytimeEECBS
 {
 public:
-    vector<Path> solution;
+    vector<CompactPath> solution;
     list<IterationStats> iteration_stats; //stats about each iteration
     double preprocessing_time = 0;
     double runtime = 0;
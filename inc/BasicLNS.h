@@ -25,6 +25,14 @@ struct Agent
         else
             path_planner = new SpaceTimeAStar(instance, id);
     }
+    Agent(const Agent& other) : id(other.id), path(other.path) // deep copy, reusing the precomputed heuristics
+    {
+        if (auto sipp = dynamic_cast<const SIPP*>(other.path_planner))
+            path_planner = new SIPP(*sipp);
+        else
+            path_planner = new SpaceTimeAStar(*dynamic_cast<const SpaceTimeAStar*>(other.path_planner));
+    }
+    Agent& operator=(const Agent&) = delete;
     ~Agent(){ delete path_planner; }
 
     int getNumOfDelays() const
@@ -38,8 +46,8 @@ struct Neighbor
     vector<int> agents;
     int sum_of_costs;
     int old_sum_of_costs;
-    set<pair<int, int>> colliding_pairs;  // id1 < id2
-    set<pair<int, int>> old_colliding_pairs;  // id1 < id2
+    vector<pair<int, int>> colliding_pairs;  // id1 < id2, sorted without duplicates
+    vector<pair<int, int>> old_colliding_pairs;  // id1 < id2, sorted without duplicates
     vector<Path> old_paths;
 };
 
@@ -71,6 +79,7 @@ public:
         neighborhoodBanditStats.clear();
     }
     virtual string getSolverName() const = 0;
+    void setSeed(int seed) { this->seed = seed; generator.seed(seed); }
 protected:
     // input params
     const Instance& instance; // avoid making copies of this variable as much as possible
@@ -88,7 +97,9 @@ protected:
 	double lambda0 = 0.01;
 	double alpha0 = 1;
 	double beta0 = 100;
-    std::mt19937 generator;
+    int seed = 0;
+    std::mt19937 generator; // the only source of randomness of this solver and the solvers it calls
+    int getRandomInt(int n) { return (int)(generator() % n); } // uniform-ish in [0, n)
 
     // adaptive LNS
     bool ALNS = false;
@@ -122,4 +133,10 @@ protected:
      */
     int sampleDestroyHeuristic(BanditStats* stats);
     void updateDestroyWeights(BanditStats* stats, const double value, const bool condition);
+
+    // checkpoints of the statistics, the bandits and the random engine
+    void saveState(std::ostream& out) const;
+    bool loadState(std::istream& in); // returns false if the stream fails or the bandits have different arms
+    static void saveBanditStats(std::ostream& out, const BanditStats& stats);
+    static bool loadBanditStats(std::istream& in, BanditStats& stats);
 };
\ No newline at end of file
@@ -1,8 +1,11 @@
 #pragma once
+#include <atomic>
+#include <thread>
 #include "CBSHeuristic.h"
 #include "RectangleReasoning.h"
 #include "CorridorReasoning.h"
 #include "MutexReasoning.h"
+#include "NodePool.h"
 
 enum high_level_solver_type { ASTAR, ASTAREPS, NEW, EES };
 
@@ -65,6 +68,9 @@ public:
 		suboptimality = w;
 	}
 	void setNodeLimit(int n) { node_limit = n; }
+	void setSeed(unsigned int seed) { random_engine.seed(seed); }
+	void setInterrupt(const std::atomic<bool>* flag) { interrupt = flag; } // stop as if timed out once *flag is raised
+	void setNumOfThreads(int n) { num_of_threads = max(n, 1); } // threads for building the MDDs of the root node
 
 	////////////////////////////////////////////////////////////////////////////////////////////
 	// Runs the algorithm until the problem is solved or time is exhausted 
@@ -111,6 +117,7 @@ protected:
 	CBSHeuristic heuristic_helper;
 
 	list<HLNode*> allNodes_table; // this is ued for both ECBS and EES
+	NodePool<CBSNode> node_pool;
 
 	string getSolverName() const;
 
@@ -121,16 +128,22 @@ protected:
 	int cost_lowerbound = 0;
 	int inadmissible_cost_lowerbound;
 	int node_limit = MAX_NODES;
+	int num_of_threads = max((int)std::thread::hardware_concurrency(), 1);
+	static const int MIN_PARALLEL_MDDS = 32; // fewer MDDs than this are not worth the threads
+	const std::atomic<bool>* interrupt = nullptr;
+	mutable std::mt19937 random_engine; // used by disjoint splitting and random root orders
+	bool isInterrupted() const { return interrupt != nullptr && interrupt->load(); }
 	int cost_upperbound = MAX_COST;
 
 	vector<ConstraintTable> initial_constraints;
-	clock_t start;
+	high_resolution_clock::time_point start;
 
 	int num_of_agents;
 
 
 
 	vector<Path> paths_found_initially;  // contain initial paths found
+	const HLNode* paths_node = nullptr; // the CT node that paths belong to
 	vector < SingleAgentSolver* > search_engines;  // used to find (single) agents' paths and mdd
 
 	void addConstraints(const HLNode* curr, HLNode* child1, HLNode* child2) const;
@@ -143,6 +156,7 @@ protected:
 		list<shared_ptr<Conflict>>& copy, const list<int>& excluded_agent) ;
 	void removeLowPriorityConflicts(list<shared_ptr<Conflict>>& conflicts) const;
 	void computeSecondPriorityForConflict(Conflict& conflict, const HLNode& node);
+	void buildMDDsInParallel(HLNode& node, const vector<pair<int, size_t>>& agents);
 
 	inline void releaseNodes();
 
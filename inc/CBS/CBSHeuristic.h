@@ -2,6 +2,7 @@
 #include "MDD.h"
 #include "RectangleReasoning.h"
 #include "CorridorReasoning.h"
+#include <boost/functional/hash.hpp>
 
 
 enum heuristics_type { ZERO, CG, DG, WDG, GLOBAL, PATH, LOCAL, CONFLICT, STRATEGY_COUNT }; //  GREEDY,
@@ -209,10 +210,17 @@ private:
 
 	double time_limit;
 	int node_limit = 4;  // terminate the sub CBS solver if the number of its expanded nodes exceeds the node limit.
-	double start_time;
+	high_resolution_clock::time_point start_time;
 	int ILP_node_threshold = 5; // when #nodes >= ILP_node_threshold, use ILP solver; otherwise, use DP solver
 	int ILP_edge_threshold = 10; // when #edges >= ILP_edge_threshold, use ILP solver; otherwise, use DP solver
 	int ILP_value_threshold = 32; // when value >= ILP_value_threshold, use ILP solver; otherwise, use DP solver
+	enum { MAX_BITSET_MVC_NODES = 64, MAX_MVC_MEMO_SIZE = 1 << 16 };
+	uint64_t num_of_MVC_branches = 0;
+	// (weighted) mvcs of the components of the heuristic graphs, which mostly repeat in sibling CT nodes
+	unordered_map<vector<int>, int, boost::hash<vector<int>>> mvc_memo;
+	vector<int> mvc_key;
+	static void getComponentKey(const vector<int>& G, int num, bool weighted, vector<int>& key);
+	void memoizeMVC(int value); // memoize the value of mvc_key
 	const vector<Path*>& paths;
 	const vector<SingleAgentSolver*>& search_engines;
 	const vector<ConstraintTable>& initial_constraints;
@@ -228,8 +236,8 @@ private:
     tuple<int, int, int> solve2Agents(int a1, int a2, const ECBSNode& node); // return h value and num of CT nodes
 	static bool SyncMDDs(const MDD &mdd1, const MDD& mdd2); 	// Match and prune MDD according to another MDD.
 	int minimumVertexCover(const vector<int>& CG); // mvc on disjoint components
-	int minimumVertexCover(const vector<int>& CG, int old_mvc, int cols, int num_of_edges); // incremental mvc
-	bool KVertexCover(const vector<int>& CG, int num_of_CGnodes, int num_of_CGedges, int k, int cols);
+	int bitsetVertexCover(const vector<int>& G, int num);
+	int branchVertexCover(const uint64_t* adj, uint64_t vertices, int upper_bound);
 	int greedyMatching(const vector<bool>& CG, int cols);
     static int greedyMatching(const std::vector<int>& CG,  int cols);
     static int greedyWeightedMatching(const vector<int>& CG, int cols);
@@ -1,6 +1,7 @@
 #pragma once
 #include "common.h"
 #include "Conflict.h"
+#include "NewPath.h"
 
 enum node_selection { NODE_RANDOM, NODE_H, NODE_DEPTH, NODE_CONFLICTS, NODE_CONFLICTPAIRS, NODE_MVC };
 
@@ -134,7 +135,7 @@ public:
 	pairing_heap< CBSNode*, compare<CBSNode::compare_node_by_d> >::handle_type focal_handle;
 
 	CBSNode* parent;
-	list< pair< int, Path> > paths; // new paths
+	list<NewPath> paths; // new paths
 	inline int getFHatVal() const override { return g_val + cost_to_go; }
 	inline int getNumNewPaths() const override { return (int) paths.size(); }
 	inline string getName() const override { return "CBS Node"; }
@@ -142,7 +143,7 @@ public:
 	{
 		list<int> rst;
 		for (const auto& path : paths)
-			rst.push_back(path.first);
+			rst.push_back(path.agent);
 		return rst;
 	}
 };
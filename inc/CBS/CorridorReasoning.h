@@ -20,6 +20,36 @@ private:
 	const vector<SingleAgentSolver*>& search_engines;
 	const vector<ConstraintTable>& initial_constraints;
 
+	// The travel times are memoized, as the same queries repeat when classifying the same conflicts
+	// in sibling CT nodes, where the constraints on the queried agent have not changed.
+	struct TravelTimeQuery
+	{
+		int agent;
+		int start;
+		int end;
+		pair<int, int> blocked_edge; // the edge blocked in both directions, (-1, -1) if none
+		vector<Constraint> constraints; // the sorted constraints of the CT node that affect the agent
+
+		bool operator==(const TravelTimeQuery& other) const
+		{
+			return agent == other.agent && start == other.start && end == other.end &&
+				blocked_edge == other.blocked_edge && constraints == other.constraints;
+		}
+		struct Hasher
+		{
+			std::size_t operator()(const TravelTimeQuery& query) const;
+		};
+	};
+	struct TravelTime
+	{
+		int length; // MAX_TIMESTEP if there is no path shorter than upper_bound
+		int upper_bound;
+	};
+	unordered_map<TravelTimeQuery, TravelTime, TravelTimeQuery::Hasher> travel_times;
+
+	void getConstraints(const HLNode& node, int agent, vector<Constraint>& constraints) const;
+	int getTravelTime(TravelTimeQuery& query, const HLNode& node, int upper_bound);
+
 	shared_ptr<Conflict> findCorridorConflict(const shared_ptr<Conflict>& conflict,
 		const vector<Path*>& paths, const HLNode& node);
 	int findCorridor(const shared_ptr<Conflict>& conflict,
@@ -24,10 +24,12 @@ private:
 	vector< pair<Path, int> > paths_found_initially;  // contain initial paths found
 
 	pairing_heap< ECBSNode*, compare<ECBSNode::compare_node_by_f> > cleanup_list; // it is called open list in ECBS
-	pairing_heap< ECBSNode*, compare<ECBSNode::compare_node_by_inadmissible_f> > open_list; // this is used for EES
+	// this is used for EES; it is ordered so that FOCAL can be updated by the nodes whose f^-vals cross the threshold
+	std::multiset< ECBSNode*, ECBSNode::order_node_by_inadmissible_f > open_list;
 	pairing_heap< ECBSNode*, compare<ECBSNode::compare_node_by_d> > focal_list; // this is ued for both ECBS and EES
+	NodePool<ECBSNode> node_pool;
 
-	void adoptBypass(ECBSNode* curr, ECBSNode* child, const vector<int>& fmin_copy);
+	void adoptBypass(ECBSNode* curr, ECBSNode* child);
 
 	// node operators
 	void pushNode(ECBSNode* node);
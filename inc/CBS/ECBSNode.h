@@ -68,13 +68,28 @@ public:
 		}
 	};  // used by FOCAL to compare nodes by f^-val (top of the heap has min f^-val)
 
+	// the following is used to order nodes in the OPEN list of EES by f^-val (the first node has min f^-val),
+	// with the same tie-breaking as compare_node_by_inadmissible_f.
+	// Nodes can also be compared with an f^-val so that the nodes in a range of f^-vals can be looked up.
+	struct order_node_by_inadmissible_f
+	{
+		typedef void is_transparent;
+		bool operator()(const ECBSNode* n1, const ECBSNode* n2) const
+		{
+			return make_tuple(n1->getFHatVal(), n1->g_val + n1->h_val, n1->distance_to_go, n1->h_val) <
+				make_tuple(n2->getFHatVal(), n2->g_val + n2->h_val, n2->distance_to_go, n2->h_val);
+		}
+		bool operator()(const ECBSNode* n, double f_hat) const { return n->getFHatVal() < f_hat; }
+		bool operator()(double f_hat, const ECBSNode* n) const { return f_hat < n->getFHatVal(); }
+	};
+
 	pairing_heap< ECBSNode*, compare<ECBSNode::compare_node_by_f> >::handle_type cleanup_handle;
-	pairing_heap< ECBSNode*, compare<ECBSNode::compare_node_by_inadmissible_f> >::handle_type open_handle;
+	std::multiset<ECBSNode*, ECBSNode::order_node_by_inadmissible_f>::iterator open_handle;
 	pairing_heap< ECBSNode*, compare<ECBSNode::compare_node_by_d> >::handle_type focal_handle;
 
 	int sum_of_costs = 0;  // sum of costs of the paths
 	ECBSNode* parent;
-	list< pair< int, pair<Path, int> > > paths; // new paths <agent id, <path, min f>>	
+	list<NewPath> paths; // new paths with their min f vals
 	inline int getFHatVal() const { return sum_of_costs + cost_to_go; }
 	inline int getNumNewPaths() const { return (int) paths.size(); }
 	inline string getName() const { return "ECBS Node"; }
@@ -82,7 +97,7 @@ public:
 	{
 		list<int> rst;
 		for (const auto& path : paths)
-			rst.push_back(path.first);
+			rst.push_back(path.agent);
 		return rst;
 	}
 };
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 #include "GCBSNode.h"
 #include "SpaceTimeAStar.h"
+#include "NodePool.h"
 
 
 class GCBS
@@ -32,6 +33,7 @@ public:
     void setDisjointSplitting(bool d) { disjoint_splitting = d; }
     void setBypass(bool b) { bypass = b; } // 2-agent solver for heuristic calculation does not need bypass strategy.
     void setSavingStats(bool s) { save_stats = s; }
+    void setSeed(unsigned int seed) { random_engine.seed(seed); }
 
     ////////////////////////////////////////////////////////////////////////////////////////////
     // Runs the algorithm until the problem is solved or time is exhausted
@@ -48,12 +50,14 @@ public:
     void clear(); // used for rapid random  restart
 
 private:
+    const GCBSNode* paths_node = nullptr; // the CT node that paths belong to
     bool target_reasoning;  // using target reasoning
     bool disjoint_splitting;  // disjoint splitting
     bool bypass; // using Bypass1
     bool save_stats;
 
     list<GCBSNode*> allNodes_table;
+    NodePool<GCBSNode> node_pool;
     const vector<PathTable>* path_tables;
 
     pairing_heap< GCBSNode*, compare<GCBSNode::compare_node_by_d> > focal_list;
@@ -61,8 +65,9 @@ private:
     int screen;
     double time_limit = -1;
     int collision_upperbound = MAX_COST;
-    clock_t start;
+    high_resolution_clock::time_point start;
     int num_of_agents;
+    mutable std::mt19937 random_engine; // used by disjoint splitting and random root orders
 
     string getSolverName() const;
 
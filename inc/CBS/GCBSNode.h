@@ -1,5 +1,6 @@
 #pragma once
 #include "Conflict.h"
+#include "NewPath.h"
 
 
 class GCBSNode
@@ -22,7 +23,7 @@ public:
 
 
     GCBSNode* parent;
-    list< pair< int, Path > > paths; // new paths <agent id, path>
+    list<NewPath> paths; // new paths
 
     // the following is used to comapre nodes in the FOCAL list
     struct compare_node_by_d
@@ -33,7 +34,7 @@ public:
             {
                 if (n1->sum_of_costs == n2->sum_of_costs)
                 {
-                    return rand() % 2;
+                    return threadRand() % 2;
                 }
                 return n1->sum_of_costs >= n2->sum_of_costs;
             }
@@ -48,7 +49,7 @@ public:
     {
         list<int> rst;
         for (const auto& path : paths)
-            rst.push_back(path.first);
+            rst.push_back(path.agent);
         return rst;
     }
     void clear()
@@ -21,6 +21,7 @@ public:
 	int location;
 	int level;
   int cost; // minimum cost of path traversing this MDD node
+	int index = 0; // position of the node in its level, set by CBSHeuristic::SyncMDDs
 
 	bool operator == (const MDDNode & node) const
 	{
@@ -59,48 +60,6 @@ public:
 
 std::ostream& operator<<(std::ostream& os, const MDD& mdd);
 
-class SyncMDDNode
-{
-public:
-	SyncMDDNode(int currloc, SyncMDDNode* parent)
-	{
-		location = currloc;
-		if (parent != nullptr)
-		{
-			//level = parent->level + 1;
-			parents.push_back(parent);
-		}
-		//parent = NULL;
-	}
-	int location;
-	//int level;
-
-	bool operator == (const SyncMDDNode & node) const
-	{
-		return (this->location == node.location);
-	}
-
-
-	list<SyncMDDNode*> children;
-	list<SyncMDDNode*> parents;
-	list<const MDDNode*> coexistingNodesFromOtherMdds;
-
-};
-
-
-class SyncMDD
-{
-public:
-	vector<list<SyncMDDNode*>> levels;
-
-	SyncMDDNode* find(int location, int level) const;
-	void deleteNode(SyncMDDNode* node, int level);
-	void clear();
-
-	explicit SyncMDD(const MDD & cpy);
-	~SyncMDD();
-};
-
 class MDDTable
 {
 public:
@@ -119,6 +78,8 @@ public:
 
 	MDD* findMDD(HLNode& node, int agent) const;
 	MDD * getMDD(HLNode& node, int agent, size_t mdd_levels);
+	// builds the MDDs of the given (agent, levels) pairs at node on num_of_threads threads and adds them to the table
+	void buildMDDs(HLNode& node, const vector<pair<int, size_t>>& agents, int num_of_threads);
 	// void findSingletons(HLNode& node, int agent, Path& path);
 	void clear();
 private:
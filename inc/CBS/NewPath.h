@@ -0,0 +1,79 @@
+#pragma once
+#include "common.h"
+
+// A path replanned in a high-level node. Paths are never modified once stored, so nodes share them
+// (e.g., when adopting a bypass) instead of copying them.
+struct NewPath
+{
+	int agent;
+	shared_ptr<Path> path;
+	Path* previous; // the path of the agent before it was replanned in this node
+	int min_f_val; // only used by ECBS
+	int previous_min_f_val;
+
+	NewPath(int agent, Path&& path, Path* previous, int min_f_val = 0, int previous_min_f_val = 0) :
+		agent(agent), path(make_shared<Path>(std::move(path))), previous(previous),
+		min_f_val(min_f_val), previous_min_f_val(previous_min_f_val) {}
+};
+
+// Moves paths (and min f vals) from the node they currently belong to to node to, by undoing the
+// new paths up to the lowest common ancestor and redoing them down to node to.
+// So the runtime depends on the number of replanned agents between the two nodes only.
+template<class Node>
+void switchPaths(const Node* from, const Node* to, vector<Path*>& paths, vector<int>* min_f_vals = nullptr)
+{
+	list<const Node*> nodes_to_redo;
+	while (from != to)
+	{
+		if (from != nullptr and (to == nullptr or from->depth >= to->depth))
+		{
+			for (auto p = from->paths.rbegin(); p != from->paths.rend(); ++p)
+			{
+				paths[p->agent] = p->previous;
+				if (min_f_vals != nullptr)
+					(*min_f_vals)[p->agent] = p->previous_min_f_val;
+			}
+			from = from->parent;
+		}
+		else
+		{
+			nodes_to_redo.push_front(to);
+			to = to->parent;
+		}
+	}
+	for (auto node : nodes_to_redo)
+	{
+		for (const auto& p : node->paths)
+		{
+			paths[p.agent] = p.path.get();
+			if (min_f_vals != nullptr)
+				(*min_f_vals)[p.agent] = p.min_f_val;
+		}
+	}
+}
+
+// Adopts the new paths of child (a bypass) in node, sharing the paths instead of copying them.
+// The min f vals of node are kept, as the bypass does not change the lower bounds.
+template<class Node>
+void adoptPaths(Node* node, const Node* child, vector<Path*>& paths, vector<int>* min_f_vals = nullptr)
+{
+	for (const auto& path : child->paths)
+	{
+		auto p = node->paths.begin();
+		while (p != node->paths.end() and p->agent != path.agent)
+			++p;
+		if (p == node->paths.end())
+		{
+			node->paths.push_back(path);
+			p = std::prev(node->paths.end());
+			p->min_f_val = p->previous_min_f_val;
+		}
+		else
+		{
+			p->path = path.path;
+		}
+		paths[p->agent] = p->path.get();
+		if (min_f_vals != nullptr)
+			(*min_f_vals)[p->agent] = p->min_f_val;
+	}
+}
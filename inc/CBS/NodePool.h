@@ -0,0 +1,82 @@
+#pragma once
+#include "common.h"
+#include <memory>
+#include <type_traits>
+
+// Allocates the high-level nodes of a search in blocks.
+// release() hands all nodes back at once in O(1): a node is only destroyed when its memory is handed out
+// again or when the pool is destroyed, so restarting a search does not pay for tearing down the old tree.
+template<class Node>
+class NodePool
+{
+public:
+	NodePool() = default;
+	NodePool(const NodePool&) = delete;
+	NodePool& operator=(const NodePool&) = delete;
+	~NodePool()
+	{
+		for (auto& block : blocks)
+		{
+			for (size_t i = 0; i < block.touched; i++)
+				block.at(i)->~Node();
+		}
+	}
+
+	// returns a value-initialized node (as new Node() does)
+	Node* create()
+	{
+		if (!recycled.empty())
+		{
+			auto node = recycled.back();
+			recycled.pop_back();
+			node->~Node();
+			return new (node) Node();
+		}
+		if (curr_block == blocks.size() || curr_offset == blocks[curr_block].size)
+		{
+			if (curr_block < blocks.size())
+				curr_block++;
+			curr_offset = 0;
+			if (curr_block == blocks.size())
+			{
+				size_t size = blocks.empty() ? MIN_BLOCK_SIZE : 2 * blocks.back().size;
+				blocks.emplace_back(size < MAX_BLOCK_SIZE ? size : MAX_BLOCK_SIZE);
+			}
+		}
+		auto& block = blocks[curr_block];
+		auto node = block.at(curr_offset);
+		if (curr_offset < block.touched)
+			node->~Node();
+		else
+			block.touched++;
+		curr_offset++;
+		return new (node) Node();
+	}
+
+	// hands a single node back (e.g., a child that was not generated)
+	void recycle(Node* node) { recycled.push_back(node); }
+
+	// hands all nodes back
+	void release()
+	{
+		curr_block = 0;
+		curr_offset = 0;
+		recycled.clear();
+	}
+
+private:
+	enum : size_t { MIN_BLOCK_SIZE = 16, MAX_BLOCK_SIZE = 4096 };
+	typedef typename std::aligned_storage<sizeof(Node), alignof(Node)>::type Storage;
+	struct Block
+	{
+		std::unique_ptr<Storage[]> memory;
+		size_t size;
+		size_t touched = 0; // the number of slots that hold a node
+		explicit Block(size_t size) : memory(new Storage[size]), size(size) {}
+		Node* at(size_t i) { return reinterpret_cast<Node*>(&memory[i]); }
+	};
+	vector<Block> blocks;
+	size_t curr_block = 0; // the next free slot is blocks[curr_block].at(curr_offset)
+	size_t curr_offset = 0;
+	vector<Node*> recycled;
+};
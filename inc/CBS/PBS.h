@@ -1,5 +1,8 @@
 #pragma once
 #include "SingleAgentSolver.h"
+#include "NewPath.h"
+#include "NodePool.h"
+#include <boost/dynamic_bitset.hpp>
 
 typedef tuple<int, int, bool> CollidingPair; // <a1, a2, internal conflict or not>
 
@@ -8,9 +11,10 @@ struct PBSNode
     int time_expanded = -1;
     int time_generated = -1;
     int sum_of_costs = 0;
+    size_t depth = 0;
     PBSNode* parent = nullptr;
     pair<int, int> priority; // the former has lower priority than the latter task
-    list<pair<int, Path>> new_paths;
+    list<NewPath> paths; // new paths
     list<CollidingPair> conflicts;
     CollidingPair chosen_conflict;
     list<CollidingPair> abandoned_conflicts;
@@ -25,7 +29,7 @@ struct PBSNode
                 if (n1->conflicts.size() == n2->conflicts.size())
                 {
                     if (n1->sum_of_costs == n2->sum_of_costs)
-                        return rand() % 2;
+                        return threadRand() % 2;
                     return n1->sum_of_costs > n2->sum_of_costs;
                 }
                 return n1->conflicts.size() < n2->conflicts.size();
@@ -35,7 +39,7 @@ struct PBSNode
     };
     pairing_heap< PBSNode*, compare<PBSNode::compare_node> >::handle_type open_handle;
 
-    inline int getNumNewPaths() const { return (int) new_paths.size(); }
+    inline int getNumNewPaths() const { return (int) paths.size(); }
     inline string getName() const { return "PBS Node"; }
     void clear() { conflicts.clear(); }
 };
@@ -70,33 +74,37 @@ private:
     double time_limit = -1;
     int collsion_threshold = -1;
     int node_limit = -1;
-    clock_t start;
+    high_resolution_clock::time_point start;
     int num_of_agents;
     PBSNode* root_node = nullptr;
+    const PBSNode* paths_node = nullptr; // the node that paths belong to
     pairing_heap< PBSNode*, compare<PBSNode::compare_node> > open_list;
-    list<PBSNode*> all_nodes;
+    NodePool<PBSNode> node_pool;
 
-    vector<vector<bool>> priorities; // pairwise priorities among agents
+    typedef boost::dynamic_bitset<> AgentSet;
+    struct Priorities // transitively closed priorities among agents and a topological order of them
+    {
+        vector<AgentSet> higher; // agents that have higher priorities than agent i
+        vector<AgentSet> lower; // agents that have lower priorities than agent i
+        vector<int> ordered_agents; // higher priority agents first
+        vector<int> order; // position of agent i in ordered_agents
+    };
+    Priorities priorities;
+    Priorities parent_priorities; // priorities of the node whose children are being generated
+    const PBSNode* parent_of_priorities = nullptr;
     vector<list<int>> higher_external_agents; // external agents that have higher priorities
     vector<list<int>> lower_external_agents; // external agents that have lower priorities
     vector<const Path*> initial_paths;
     inline void pushNode(PBSNode* node);
     inline bool terminate();
-    void topologicalSort(list<int>& ordered_agents);
-    void topologicalSortUtil(int v, vector<bool> & visited, list<int> & stack);
+    void buildPriorities(const PBSNode* node); // build the priorities of node and its ancestors from scratch
+    void addPriority(int lower_agent, int higher_agent); // add one priority and reorder the affected agents only
     void update(PBSNode& node);
     bool generateRoot();
     bool generateChild(PBSNode& parent_node, bool left_child);
-    bool planPath(int agent, PBSNode& node, const set<int> & higher_agents, const set<int> & lower_agents);
-
-    void getHigherPriorityAgents(int agent, set<int>& higher_agents, const list<int> & ordered_agents) const;
-    void getHigherPriorityAgents(const list<int>::const_iterator & p1, set<int> & higher_agents,
-            const list<int> & ordered_agents) const;
-    void getLowerPriorityAgents(int agent, set<int>& lower_agents, const list<int> & ordered_agents) const;
-    void getLowerPriorityAgents(const list<int>::const_iterator & p1, set<int> & lower_agents,
-            const list<int> & ordered_agents) const;
+    bool planPath(int agent, PBSNode& node);
 
     bool findInternalConflicts(PBSNode& node, int a1, int a2) const;
-    bool findExternalConflicts(PBSNode& node, int a, const set<int> & lower_agents) const;
+    bool findExternalConflicts(PBSNode& node, int a) const;
     void deleteConflicts(list<CollidingPair>& conflicts, int a) const; // delete conflicts that involve agent a
 };
\ No newline at end of file
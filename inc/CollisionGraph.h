@@ -0,0 +1,42 @@
+#pragma once
+#include "common.h"
+#include <algorithm>
+
+// The collision graph of InitLNS: vertices are agents and edges are colliding pairs.
+// Adjacency lists are sorted vectors, and a Fenwick tree over the degrees samples agents
+// with probability proportional to their degrees, so that no operation scans all agents.
+class CollisionGraph
+{
+public:
+    explicit CollisionGraph(int num_of_vertices = 0);
+
+    int size() const { return (int)adj.size(); }
+    int getNumOfEdges() const { return num_of_edges; }
+    int getDegree(int v) const { return (int)adj[v].size(); }
+    const vector<int>& getNeighbors(int v) const { return adj[v]; }
+    bool hasEdge(int u, int v) const { return std::binary_search(adj[u].begin(), adj[u].end(), v); }
+    void addEdge(int u, int v); // nothing happens if the edge exists
+    void removeEdge(int u, int v); // nothing happens if the edge does not exist
+    void clear();
+
+    // vertices with at least one edge, in arbitrary order
+    int getNumOfCollidingVertices() const { return (int)colliding_vertices.size(); }
+    int getCollidingVertex(int i) const { return colliding_vertices[i]; }
+
+    // the vertex whose slice of [0, 2|E|) contains r, where each vertex owns as many slots as its degree
+    int getVertexByDegree(int r) const;
+
+    // BFS from v that stops after collecting more than max_size vertices of its connected component
+    void getComponent(int v, int max_size, vector<int>& component) const;
+
+private:
+    vector<vector<int>> adj;
+    vector<int> degree_tree; // Fenwick tree over the degrees
+    vector<int> colliding_vertices;
+    vector<int> position; // index in colliding_vertices, or -1 if the vertex has no edges
+    int num_of_edges = 0;
+
+    void addToAdjacencyList(int u, int v);
+    void removeFromAdjacencyList(int u, int v);
+    void updateDegree(int v, int delta);
+};
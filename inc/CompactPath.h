@@ -0,0 +1,37 @@
+#pragma once
+#include "common.h"
+#include <cstdint>
+
+// A path for storage rather than search: moves are 16-bit location deltas, waits are run-length encoded,
+// and every few codes the absolute timestep and location are kept as a checkpoint for random access.
+class CompactPath
+{
+public:
+	CompactPath() = default;
+	explicit CompactPath(const Path& path);
+
+	size_t size() const { return length; }
+	bool empty() const { return length == 0; }
+	int back() const { return last_location; }
+	int location(int t) const; // the location at timestep t < size()
+	void decode(Path& path) const;
+	size_t memoryUsage() const { return codes.capacity() * sizeof(int16_t) + checkpoints.capacity() * sizeof(Checkpoint); }
+	void save(std::ostream& out) const;
+	bool load(std::istream& in); // returns false if the stream fails
+
+private:
+	// code = a move by code timestep; WAIT = stay for the number of timesteps in the next code (as uint16);
+	// JUMP = move to the location in the next two codes (for deltas that do not fit 16 bits)
+	enum : int16_t { WAIT = 0, JUMP = INT16_MIN };
+	enum { CHECKPOINT_INTERVAL = 64 }; // codes between checkpoints
+	struct Checkpoint
+	{
+		int timestep;
+		int location;
+		int code; // the index of the next code
+	};
+	vector<int16_t> codes;
+	vector<Checkpoint> checkpoints;
+	int length = 0;
+	int last_location = -1;
+};
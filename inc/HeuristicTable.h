@@ -0,0 +1,50 @@
+#pragma once
+#include "Instance.h"
+#include <queue>
+
+// The distances from all locations to a goal location.
+// By default, they are computed eagerly by a backward Dijkstra search and stored as ints.
+// In compact mode, they are stored as 16-bit values in pages that are allocated on first use, and are computed
+// lazily by a resumable backward A* search (RRA*) towards the start location: a query for a location that is not
+// closed yet resumes the search until that location is closed. So the memory and the runtime scale with the area
+// that the searches actually query instead of with the map size.
+class HeuristicTable
+{
+public:
+	void compute(const Instance& instance, int goal_location, int start_location, bool compact);
+	void clear();
+
+	int operator[](int loc) const
+	{
+		if (!compact)
+			return distances[loc];
+		auto d = lookup(loc);
+		return d != UNKNOWN ? d : resume(loc);
+	}
+	// returns false if loc is not closed yet, i.e., querying it would resume the search
+	bool isComputed(int loc) const { return !compact || lookup(loc) != UNKNOWN || open.empty(); }
+
+private:
+	enum : int { PAGE_BITS = 12, PAGE_SIZE = 1 << PAGE_BITS };
+	// longer distances are stored as MAX_DISTANCE, which is still admissible
+	enum : uint16_t { UNKNOWN = 0xFFFF, MAX_DISTANCE = 0xFFFE };
+
+	const Instance* instance = nullptr;
+	bool compact = false;
+	vector<int> distances; // only used in eager mode
+
+	// compact mode
+	int start_location = -1; // the target of the backward search
+	mutable vector<vector<uint16_t>> pages; // the distances of the closed locations, UNKNOWN for the others
+	// OPEN of the backward search as <f val, location> pairs. A location can be inserted more than once,
+	// and its copies popped after the first one are skipped.
+	typedef std::pair<int, int> OpenEntry;
+	mutable std::priority_queue<OpenEntry, vector<OpenEntry>, std::greater<OpenEntry>> open;
+
+	uint16_t lookup(int loc) const
+	{
+		const auto& page = pages[loc >> PAGE_BITS];
+		return page.empty() ? (uint16_t)UNKNOWN : page[loc & (PAGE_SIZE - 1)];
+	}
+	int resume(int loc) const; // resumes the search until loc is closed
+};
@@ -1,5 +1,6 @@
 #pragma once
 #include "BasicLNS.h"
+#include "CollisionGraph.h"
 
 enum init_destroy_heuristic { TARGET_BASED, COLLISION_BASED, RANDOM_BASED, INIT_COUNT };
 
@@ -8,6 +9,7 @@ class InitLNS : public BasicLNS
 public:
     vector<Agent>& agents;
     double replan_time_limit = 0.6;
+    int window = MAX_TIMESTEP; // vertex and edge collisions after this timestep are ignored
     int num_of_colliding_pairs = 0;
 
     InitLNS(const Instance& instance, vector<Agent>& agents, double time_limit,
@@ -30,7 +32,7 @@ private:
     PathTableWC path_table; // 1. stores the paths of all agents in a time-space table;
     // 2. avoid making copies of this variable as much as possible.
 
-    vector<set<int>> collision_graph;
+    CollisionGraph collision_graph;
     vector<int> goal_table;
 
 
@@ -38,7 +40,7 @@ private:
     bool runGCBS();
     bool runPBS();
 
-    bool updateCollidingPairs(set<pair<int, int>>& colliding_pairs, int agent_id, const Path& path) const;
+    bool updateCollidingPairs(vector<pair<int, int>>& colliding_pairs, int agent_id, const Path& path) const;
 
     void chooseDestroyHeuristicbyALNS();
 
@@ -51,8 +53,5 @@ private:
 
     void printCollisionGraph() const;
 
-    static unordered_map<int, set<int>>& findConnectedComponent(const vector<set<int>>& graph, int vertex,
-            unordered_map<int, set<int>>& sub_graph);
-
     bool validatePathTable() const;
 };
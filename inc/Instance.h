@@ -10,10 +10,12 @@ public:
 	int num_of_rows;
 	int map_size;
 	string state_json;
+	bool compact_heuristics = false; // store the heuristic tables of the single-agent solvers as lazy 16-bit tables
 
 	Instance()=default;
 	Instance(const string& map_fname, const string& agent_fname, const string& state_json = "",
-		int num_of_agents = 0, int num_of_rows = 0, int num_of_cols = 0, int num_of_obstacles = 0, int warehouse_width = 0);
+		int num_of_agents = 0, int num_of_rows = 0, int num_of_cols = 0, int num_of_obstacles = 0, int warehouse_width = 0,
+		const string& cache_dir = ""); // cache_dir: directory of the binary cache of parsed instances, empty for none
 
 
 	void printAgents() const;
@@ -57,24 +59,55 @@ public:
 	int getDegree(int loc) const
 	{
 		assert(loc >= 0 && loc < map_size && !my_map[loc]);
-		int degree = 0;
-		if (0 <= loc - num_of_cols && !my_map[loc - num_of_cols])
-			degree++;
-		if (loc + num_of_cols < map_size && !my_map[loc + num_of_cols])
-			degree++;
-		if (loc % num_of_cols > 0 && !my_map[loc - 1])
-			degree++;
-		if (loc % num_of_cols < num_of_cols - 1 && !my_map[loc + 1])
-			degree++;
-		return degree;
+		return degrees[loc];
+	}
+
+	// topology index: a corridor is a maximal chain of cells of degree 2, and an intersection is a cell of degree > 2
+	struct Corridor
+	{
+		int ends[2]; // the cells next to the two ends of the chain (-1 if the chain is a cycle)
+		int length; // the distance between the two ends
+	};
+	int getCorridorId(int loc) const { return corridor_ids[loc]; } // -1 if loc is not in a corridor
+	const Corridor& getCorridor(int id) const { return corridors[id]; }
+	const vector<int>& getIntersections() const { return intersections; }
+	// the intersections that are adjacent to or connected by a corridor with intersection loc
+	pair<const int*, const int*> getAdjacentIntersections(int loc) const
+	{
+		const int* adj = intersection_adjacency.data();
+		return make_pair(adj + intersection_offsets[loc], adj + intersection_offsets[loc + 1]);
+	}
+
+	// ALT lower bound on the distance between loc1 and loc2, by the triangle inequality on the landmarks
+	int getLandmarkDistance(int loc1, int loc2) const
+	{
+		int rst = 0;
+		const int* d1 = landmark_distances.data() + loc1 * num_of_landmarks;
+		const int* d2 = landmark_distances.data() + loc2 * num_of_landmarks;
+		for (int i = 0; i < num_of_landmarks; i++)
+		{
+			if (d1[i] < MAX_TIMESTEP && d2[i] < MAX_TIMESTEP) // skip landmarks that cannot reach either location
+				rst = max(rst, abs(d1[i] - d2[i]));
+		}
+		return rst;
 	}
 
 	int getDefaultNumberOfAgents() const { return num_of_agents; }
 	string getInstanceName() const { return agent_fname; }
     void savePaths(const string & file_name, const vector<Path*>& paths) const;
-    bool validateSolution(const vector<Path*>& paths, int sum_of_costs, int num_of_colliding_pairs) const;
+    bool validateSolution(const vector<Path*>& paths, int sum_of_costs, int num_of_colliding_pairs,
+		int window = MAX_TIMESTEP) const; // vertex and edge conflicts after the window are ignored
 private:
 	  vector<bool> my_map;
+	  vector<uint8_t> degrees;
+	  vector<int> corridor_ids;
+	  vector<Corridor> corridors;
+	  vector<int> intersections;
+	  vector<int> intersection_offsets; // the adjacency of the intersection graph in CSR format, indexed by location
+	  vector<int> intersection_adjacency;
+	  enum { MAX_NUM_OF_LANDMARKS = 8 };
+	  int num_of_landmarks = 0;
+	  vector<int> landmark_distances; // the distances from the landmarks, indexed by location * num_of_landmarks + landmark
 	  string map_fname;
 	  string agent_fname;
 
@@ -91,12 +124,24 @@ private:
 	  void saveAgents() const;
 	  void saveNathan() const;
 
+	  // binary cache of the parsed map and agents
+	  struct CacheHeader;
+	  string cache_dir;
+	  static string getFileKey(const string& fname);
+	  string getCacheFile(const string& kind, const string& key) const;
+	  bool loadMapCache(const string& fname);
+	  void saveMapCache(const string& fname) const;
+	  bool loadAgentsCache(const string& fname);
+	  void saveAgentsCache(const string& fname) const;
+
 	  void generateConnectedRandomGrid(int rows, int cols, int obstacles); // initialize new [rows x cols] map with random obstacles
 	  void generateRandomAgents(int warehouse_width);
 	  bool addObstacle(int obstacle); // add this obsatcle only if the map is still connected
 	  bool isConnected(int start, int goal); // run BFS to find a path between start and goal, return true if a path exists.
 
 	  int randomWalk(int loc, int steps) const;
+	  void buildTopology();
+	  void buildLandmarks();
 
 	  // Class  SingleAgentSolver can access private members of Node 
 	  friend class SingleAgentSolver;
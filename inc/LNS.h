@@ -1,9 +1,10 @@
 #pragma once
 #include "BasicLNS.h"
 #include "InitLNS.h"
+#include <atomic>
 
 //pibt related
-#include "simplegrid.h"
+#include "instancegrid.h"
 #include "pibt_agent.h"
 #include "problem.h"
 #include "mapf.h"
@@ -27,17 +28,35 @@ public:
     int log_step = 1;
     string state_json = "";
     double replan_time_limit = 0.6;
+    vector<string> init_portfolio; // initial solvers raced in parallel (overrides init_algo_name when non-empty)
+    double portfolio_grace = 0; // seconds the other portfolio workers may keep improving after the first success
+    // rolling-horizon lifelong mode: every tick, LNS improves the plan for tick_time seconds, the first horizon
+    // timesteps are committed, and the agents that reached their goals get new ones from goal_stream
+    string goal_stream = ""; // text file of new goals as "row col" pairs (more can be appended while running)
+    int horizon = 5;
+    double tick_time = 1;
+    int num_of_ticks = 0; // 0 for running until the goal stream is exhausted and all agents are at their goals
+    // windowed MAPF: collisions after this timestep are ignored (meant for the lifelong mode, where the conflicts
+    // that enter the window are repaired at every tick)
+    int window = MAX_TIMESTEP;
+    // checkpoints of the complete search state, written every checkpoint_interval seconds (0 for only at the end)
+    // and resumed from if resume is set and checkpoint_file exists (not supported in lifelong mode)
+    string checkpoint_file = "";
+    double checkpoint_interval = 0;
+    bool resume = false;
 
     LNS(const Instance& instance, double time_limit,
         const string & init_algo_name, const string & replan_algo_name, const string & destroy_name,
         int neighbor_size, int num_of_iterations, bool init_lns, const string & init_destroy_name, bool use_sipp,
         int screen, PIBTPPS_option pipp_option, const string & bandit_algorithm_name, int neighborhoodSizes);
+    LNS(const LNS& other, const string & init_algo_name); // portfolio worker with its own agents and path table
     ~LNS()
     {
         delete init_lns;
     }
     bool getInitialSolution();
     bool run();
+    bool runLifelong();
     void validateSolution() const;
     void writeIterStatsToFile(const string & file_name) const;
     void writeResultToFile(const string & file_name) const;
@@ -47,28 +66,52 @@ private:
     InitLNS* init_lns = nullptr;
     string init_algo_name;
     string replan_algo_name;
+    vector<string> repair_algos; // the bandit chooses among them when replan_algo_name is Adaptive
+    BanditStats repairBanditStats;
     bool use_init_lns; // use LNS to find initial solutions
     destroy_heuristic destroy_strategy = RANDOMWALK;
     int num_of_iterations;
     string init_destroy_name;
     PIBTPPS_option pipp_option;
-
+    const std::atomic<bool>* interrupt = nullptr; // raised when a portfolio worker should give up
+    bool isInterrupted() const { return interrupt != nullptr && interrupt->load(); }
 
     PathTable path_table; // 1. stores the paths of all agents in a time-space table;
     // 2. avoid making copies of this variable as much as possible.
     unordered_set<int> tabu_list; // used by randomwalk strategy
-    list<int> intersections;
+    vector<int> intersection_visits; // the last generateNeighborByIntersection call that visited each intersection
+    int num_of_intersection_searches = 0;
+    std::unique_ptr<Graph> pibt_graph; // built from the instance on the first PIBT call and reused afterwards
+    double lns_runtime = 0; // the time spent on LNS iterations
+
+    // lifelong mode
+    std::ifstream goal_input;
+    list<int> pending_goals; // goals read from the stream that could not be assigned yet
+    vector<Path> executed_paths; // the committed prefixes of the paths
+    int num_of_finished_tasks = 0;
+
+    bool initializeSolution();
+    void saveCheckpoint() const;
+    bool loadCheckpoint(); // returns false if there is no checkpoint to resume from
+    void runIteration();
+    bool commitPrefix(); // returns false if the conflicts that enter the window cannot be resolved in time
+    bool assignGoals(); // returns false if no agent got a new goal
+    bool assignGoal(int agent, int goal);
+    bool readGoal(int& goal);
 
     bool runEECBS();
     bool runCBS();
     bool runPP();
+    bool runPortfolio();
     bool runPIBT();
     bool runPPS();
     bool runWinPIBT();
+    bool runPIBTRepair(bool windowed); // PIBT or winPIBT around the agents outside the neighborhood
 
 
     MAPF preparePIBTProblem(vector<int>& shuffled_agents);
-    void updatePIBTResult(const PIBT_Agents& A, vector<int>& shuffled_agents);
+    bool updatePIBTResult(const PIBT_Agents& A, vector<int>& shuffled_agents);
+    bool isConsistentWithPathTable(const Path& path) const;
 
     void chooseDestroyHeuristicbyALNS();
 
@@ -76,7 +119,7 @@ private:
     bool generateNeighborByIntersection();
 
     int findMostDelayedAgent();
-    int findRandomAgent() const;
+    int findRandomAgent();
     void randomWalk(int agent_id, int start_location, int start_timestep,
                     set<int>& neighbor, int neighbor_size, int upperbound);
 };
@@ -47,6 +47,8 @@ private:
 protected:
   // nodes
   Nodes nodes;
+  Nodes nodeTable;  // node of each id, nullptr for obstacles
+  void buildNodeTable();  // call after creating the nodes
 
   // cache of searched path
   std::unordered_map<std::string, KnownPath*> knownPaths;
@@ -68,10 +70,12 @@ protected:
 public:
   Graph();
   Graph(std::mt19937* _MT);
-  ~Graph();
+  virtual ~Graph();
 
   Node* getNode(int id);
   bool existNode(int id);
+  void clearKnownPaths();
+  int getKnownPathsNum() { return knownPaths.size(); }
   Node* getNode(int x, int y);
   Nodes getNodes() { return nodes; }
   int getNodesNum() { return nodes.size(); }
@@ -0,0 +1,30 @@
+/*
+ * instancegrid.h
+ *
+ * Purpose: grid built from an already loaded instance,
+ *          so the map file is not parsed again for every PIBT call
+ */
+
+#pragma once
+#include "grid.h"
+#include "Instance.h"
+
+class InstanceGrid : public Grid {
+protected:
+  std::string filename;
+  const Instance& instance;
+
+public:
+  InstanceGrid(const Instance& instance, std::mt19937* _MT);
+  ~InstanceGrid() {}
+
+  std::string getMapName() { return filename; }
+
+  // node ids are locations, so the landmarks of the instance tighten the manhattan distance
+  int dist(Node* v1, Node* v2) {
+    return std::max(manhattanDist(v1, v2),
+                    instance.getLandmarkDistance(v1->getId(), v2->getId()));
+  }
+
+  std::string logStr();
+};
@@ -12,11 +12,9 @@ private:
   std::vector<Node*> neighbor;
   Vec2f pos;
 
-  static int cntIndex;
-
 public:
   Node();
-  Node(int _id);
+  Node(int _id, int _index);  // index: position in the graph node list
   ~Node() {};
 
   std::vector<Node*> getNeighbor() { return neighbor; }
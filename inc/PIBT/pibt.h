@@ -9,6 +9,7 @@ protected:
   std::vector<float> epsilon;  // tie-breaker
   std::vector<int> eta;  // usually increment every step
   std::vector<float> priority;  // eta + epsilon
+  bool stuck = false;  // an agent can neither move nor stay because of obstacles
 
   void init();
   void allocate();
@@ -32,6 +33,7 @@ protected:
                                    std::vector<float>& PL);
   virtual Node* chooseNode(PIBT_Agent* a, Nodes C);
   void updateC(Nodes& C, Node* target, Nodes CLOSE_NODE);
+  bool isTrap(Node* v);
 
   float getDensity(PIBT_Agent* a);  // density can be used as effective prioritization
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include "node.h"
 #include "task.h"
 
@@ -13,7 +14,7 @@ struct AgentStatus {
 class PIBT_Agent {
 private:
     int id;
-    static int cntId;  // for uuid
+    static std::atomic<int> cntId;  // for uuid
     Node* v;           // current node
     Node* g;           // current goal
     Task* tau;         // task
@@ -25,6 +26,7 @@ private:
 public:
     PIBT_Agent();
     PIBT_Agent(Node* v);  // initial location
+    PIBT_Agent(Node* v, int _id);  // explicit id, used as an index by the solvers
     ~PIBT_Agent();
 
     int getId() { return id; }
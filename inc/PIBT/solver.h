@@ -3,8 +3,9 @@
 #include "problem.h"
 #include <vector>
 #include <algorithm>
+#include <atomic>
 #include <chrono>
-#include <Eigen/Core>
+#include <functional>
 #include <unordered_map>
 #include <unordered_set>
 #include <boost/heap/fibonacci_heap.hpp>
@@ -24,7 +25,10 @@ protected:
   PIBT_Agents A;
   Graph* G;
 
-  Eigen::MatrixXi dists;
+  // dists[g][v]: distance from v to g, 0 if not known yet
+  // columns are allocated per goal on demand instead of a |V|x|V| matrix
+  std::unordered_map<int, std::vector<int>> dists;
+  std::vector<int>& distsTo(int g_index);
 
   void init();
   int getMaxLengthPaths(Paths& paths);
@@ -40,6 +44,18 @@ protected:
   std::chrono::system_clock::time_point startT;
   std::chrono::system_clock::time_point endT;
   double time_limit=0;
+  const std::atomic<bool>* interrupt = nullptr;  // raised by the caller to stop early
+  bool isInterrupted() const { return interrupt != nullptr && interrupt->load(); }
+
+  // space-time obstacles that are not agents of the problem,
+  // e.g., the agents outside an LNS neighborhood
+  std::function<bool(int, int, int)> blocked;  // (from, to, to_time)
+  int obstacleHorizon = 0;  // obstacles do not move after this timestep
+  bool isBlocked(Node* v, Node* u, int t) const {
+    return blocked && blocked(v->getId(), u->getId(), t);
+  }
+  bool isFinished();
+  bool overTimestepLimit();
 
 public:
   Solver(Problem* _P);
@@ -48,6 +64,11 @@ public:
 
   void WarshallFloyd();
   void setTimeLimit(double limit){this->time_limit=limit;};
+  void setInterrupt(const std::atomic<bool>* flag){this->interrupt=flag;};
+  void setObstacles(std::function<bool(int, int, int)> f, int horizon) {
+    blocked = f;
+    obstacleHorizon = horizon;
+  }
 
 
     virtual bool solve() { return false; };
@@ -1,5 +1,6 @@
 #pragma once
 #include "common.h"
+#include <boost/container/small_vector.hpp>
 
 #define NO_AGENT -1
 
@@ -7,15 +8,26 @@ class PathTable
 {
 public:
     int makespan = 0;
+    // windowed MAPF: vertex and edge conflicts after the window are ignored, so only the first window + 1 timesteps
+    // of the paths are stored in table; the rest only count the agents at each location for the holding times,
+    // as target conflicts are not windowed (otherwise an agent could stay forever where others still have to pass)
+    int window = MAX_TIMESTEP;
     vector< vector<int> > table; // this stores the collision-free paths, the value is the id of the agent
+    vector< vector<int> > late_visits; // the number of agents at [location][timestep - window - 1]
     vector<int> goals; // this stores the goal locatons of the paths: key is the location, while value is the timestep when the agent reaches the goal
-    void reset() { auto map_size = table.size(); table.clear(); table.resize(map_size); goals.assign(map_size, MAX_COST); makespan = 0; }
+    void reset()
+    {
+        auto map_size = table.size();
+        table.clear(); table.resize(map_size);
+        late_visits.clear();
+        goals.assign(map_size, MAX_COST); makespan = 0;
+    }
     void insertPath(int agent_id, const Path& path);
     void deletePath(int agent_id, const Path& path);
     bool constrained(int from, int to, int to_time) const;
 
     void get_agents(set<int>& conflicting_agents, int loc) const;
-    void get_agents(set<int>& conflicting_agents, int neighbor_size, int loc) const;
+    void get_agents(set<int>& conflicting_agents, int neighbor_size, int loc, std::mt19937& rng) const;
     void getConflictingAgents(int agent_id, set<int>& conflicting_agents, int from, int to, int to_time) const;;
     int getHoldingTime(int location, int earliest_timestep) const;
     explicit PathTable(int map_size = 0) : table(map_size), goals(map_size, MAX_COST) {}
@@ -25,7 +37,10 @@ class PathTableWC // with collisions
 {
 public:
     int makespan = 0;
-    vector< vector< list<int> > > table; // this stores the paths, the value is the id of the agent
+    int window = MAX_TIMESTEP; // vertex and edge collisions after the window are not counted (see PathTable)
+    // agents occupying a location at a timestep; rarely more than two, so they are stored inline
+    typedef boost::container::small_vector<int, 2> Occupants;
+    vector< vector<Occupants> > table; // this stores the paths, the value is the id of the agent
     vector<int> goals; // this stores the goal locatons of the paths: key is the location, while value is the timestep when the agent reaches the goal
     void reset() { auto map_size = table.size(); table.clear(); table.resize(map_size); goals.assign(map_size, MAX_COST); makespan = 0; }
     void insertPath(int agent_id, const Path& path);
@@ -0,0 +1,69 @@
+#pragma once
+#include "common.h"
+#include <memory>
+
+// Wall-clock profile of a run, aggregated as a tree of nested scopes (e.g., LNS iteration > repair > CT node >
+// low-level search) with counters attached to the scopes. Each thread records into its own tree, and the trees are
+// merged when the profile is written. Nothing is recorded unless Profiler::enable() is called, and compiling with
+// NO_PROFILING removes the scopes and counters altogether.
+class Profiler
+{
+public:
+	struct Scope
+	{
+		const char* name;
+		Scope* parent;
+		double seconds = 0;
+		uint64_t calls = 0;
+		vector<pair<const char*, uint64_t>> counters;
+		vector<std::unique_ptr<Scope>> children;
+
+		Scope(const char* name, Scope* parent) : name(name), parent(parent) {}
+		Scope* getChild(const char* child_name);
+		void count(const char* counter_name, uint64_t n);
+		void merge(const Scope& other);
+	};
+
+	static void enable() { enabled = true; } // must be called before the solvers start their threads
+	static bool isEnabled() { return enabled; }
+	static Scope* enter(const char* name); // enters the child scope of the current scope of the thread
+	static void leave(Scope* scope, double seconds);
+	static void count(const char* name, uint64_t n); // adds n to the counter of the current scope
+	static void write(const string& file_name); // writes the merged tree as JSON
+
+private:
+	static bool enabled;
+	static Scope*& current(); // the current scope of the calling thread
+};
+
+class ScopedTimer
+{
+public:
+	explicit ScopedTimer(const char* name) :
+		scope(Profiler::isEnabled() ? Profiler::enter(name) : nullptr)
+	{
+		if (scope != nullptr)
+			start = Time::now();
+	}
+	~ScopedTimer()
+	{
+		if (scope != nullptr)
+			Profiler::leave(scope, std::chrono::duration<double>(Time::now() - start).count());
+	}
+	ScopedTimer(const ScopedTimer&) = delete;
+	ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+	Profiler::Scope* scope;
+	Time::time_point start;
+};
+
+#ifdef NO_PROFILING
+#define PROFILE_SCOPE(name)
+#define PROFILE_COUNT(name, n)
+#else
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(name) ScopedTimer PROFILE_CONCAT(scoped_timer_, __LINE__)(name)
+#define PROFILE_COUNT(name, n) do { if (Profiler::isEnabled()) Profiler::count(name, n); } while (false)
+#endif
@@ -1,5 +1,5 @@
 ﻿#pragma once
-#include <boost/functional/hash.hpp>
+#include <boost/container/small_vector.hpp>
 #include "SingleAgentSolver.h"
 #include "ReservationTable.h"
 
@@ -28,32 +28,6 @@ public:
         high_expansion = other.high_expansion;
         collision_v = other.collision_v;
     }
-	// The following is used by for generating the hash value of a nodes
-	struct NodeHasher
-	{
-		std::size_t operator()(const SIPPNode* n) const
-		{
-            size_t seed = 0;
-            boost::hash_combine(seed, n->location);
-            boost::hash_combine(seed, n->high_generation);
-            return seed;
-		}
-	};
-
-	// The following is used for checking whether two nodes are equal
-	// we say that two nodes, s1 and s2, are equal if
-	// both are non-NULL and agree on the id and timestep
-	struct eqnode
-	{
-		bool operator()(const SIPPNode* n1, const SIPPNode* n2) const
-		{
-			return (n1 == n2) ||
-			            (n1 && n2 && n1->location == n2->location &&
-				        n1->wait_at_goal == n2->wait_at_goal &&
-				        n1->is_goal == n2->is_goal &&
-                         n1->high_generation == n2->high_generation);
-		}
-	};
 };
 
 class SIPP: public SingleAgentSolver
@@ -83,19 +57,33 @@ private:
 	heap_open_t open_list;
 	heap_focal_t focal_list;
 
-	// define typedef for hash_map
-	typedef boost::unordered_map<SIPPNode*, list<SIPPNode*>, SIPPNode::NodeHasher, SIPPNode::eqnode> hashtable_t;
-    hashtable_t allNodes_table;
+	// the generated nodes at the same location with the same safe interval (i.e., high_generation),
+	// which are checked against each other for dominance
+	struct NodeSlot
+	{
+	    int location;
+	    int high_generation;
+	    bool wait_at_goal;
+	    bool is_goal;
+	    int next; // the next slot at the same location
+	    boost::container::small_vector<SIPPNode*, 2> nodes;
+	    NodeSlot(const SIPPNode& node, int next) : location(node.location), high_generation(node.high_generation),
+	        wait_at_goal(node.wait_at_goal), is_goal(node.is_goal), next(next) {}
+	};
+	vector<NodeSlot> allNodes_table;
+	// location -> the index of its most recent slot in allNodes_table (-1 if none). It is all -1 between searches,
+	// so it is shared by the solvers of a thread instead of taking memory of the map size per agent.
+	static thread_local vector<int> first_slots;
     list<SIPPNode*> useless_nodes;
 
     void updatePath(const LLNode* goal, std::vector<PathEntry> &path);
 
-	inline void pushNodeToOpenAndFocal(SIPPNode* node);
-    inline void pushNodeToFocal(SIPPNode* node);
+	inline void pushNodeToOpenAndFocal(SIPPNode* node, int slot);
+    inline void pushNodeToFocal(SIPPNode* node, int slot);
     inline void eraseNodeFromLists(SIPPNode* node);
 	void updateFocalList();
 	void releaseNodes();
-    bool dominanceCheck(SIPPNode* new_node);
+    int dominanceCheck(SIPPNode& new_node); // return the slot of the new node, or -1 if it is dominated
 	void printSearchTree() const;
 };
 
@@ -1,6 +1,7 @@
 ﻿#pragma once
 #include "Instance.h"
 #include "ConstraintTable.h"
+#include "HeuristicTable.h"
 
 class LLNode // low-level node
 {
@@ -24,7 +25,7 @@ public:
             {
                 if (n1->h_val == n2->h_val)
                 {
-                    return rand() % 2 == 0;   // break ties randomly
+                    return threadRand() % 2 == 0;   // break ties randomly
                 }
                 return n1->h_val >= n2->h_val;  // break ties towards smaller h_vals (closer to goal location)
             }
@@ -43,7 +44,7 @@ public:
                 {
                     if (n1->h_val == n2->h_val)
                     {
-                        return rand() % 2 == 0;   // break ties randomly
+                        return threadRand() % 2 == 0;   // break ties randomly
                     }
                     return n1->h_val >= n2->h_val;  // break ties towards smaller h_vals (closer to goal location)
                 }
@@ -91,10 +92,11 @@ public:
 
 	int start_location;
 	int goal_location;
-	vector<int> my_heuristic;  // this is the precomputed heuristic for this agent
+	HeuristicTable my_heuristic;  // this is the precomputed heuristic for this agent (computed lazily in compact mode)
 	int compute_heuristic(int from, int to) const  // compute admissible heuristic between two locations
 	{
-		return max(get_DH_heuristic(from, to), instance.getManhattanDistance(from, to));
+		return max(max(get_DH_heuristic(from, to), instance.getLandmarkDistance(from, to)),
+			instance.getManhattanDistance(from, to));
 	}
 	const Instance& instance;
 
@@ -119,6 +121,7 @@ public:
 		compute_heuristics();
 	}
 	virtual ~SingleAgentSolver()= default;
+	void setGoalLocation(int goal) { goal_location = goal; compute_heuristics(); } // used by lifelong MAPF
     void reset()
     {
         if (num_generated > 0)
@@ -141,6 +144,11 @@ protected:
 	double w = 1; // suboptimal bound
 
 	void compute_heuristics();
-	int get_DH_heuristic(int from, int to) const { return abs(my_heuristic[from] - my_heuristic[to]); }
+	int get_DH_heuristic(int from, int to) const
+	{
+		if (!my_heuristic.isComputed(from) || !my_heuristic.isComputed(to)) // do not expand the lazy table for it
+			return 0;
+		return abs(my_heuristic[from] - my_heuristic[to]);
+	}
 };
 
@@ -10,6 +10,7 @@
 #include <iomanip>      // std::setprecision
 #include <chrono>
 #include <utility>
+#include <random>
 #include <boost/heap/pairing_heap.hpp>
 #include <boost/unordered_set.hpp>
 #include <boost/unordered_map.hpp>
@@ -56,6 +57,42 @@ typedef vector<PathEntry> Path;
 std::ostream& operator<<(std::ostream& os, const Path& path);
 bool isSamePath(const Path& p1, const Path& p2);
 
+// Random engine of the calling thread, for code that has no solver-owned engine to draw from
+// (e.g., tie-breaking inside heap comparators). Seed it per thread to make runs reproducible.
+std::mt19937& threadRandomEngine();
+inline int threadRand() { return (int)(threadRandomEngine()() >> 1); } // thread-safe replacement for rand()
+
+// Raw binary I/O of trivially copyable values, vectors of them, and strings, used by the checkpoints.
+// The read functions return false once the stream fails.
+template<class T> void writeBinary(std::ostream& out, const T& value) { out.write((const char*)&value, sizeof(T)); }
+template<class T> bool readBinary(std::istream& in, T& value) { return (bool)in.read((char*)&value, sizeof(T)); }
+template<class T> void writeBinary(std::ostream& out, const vector<T>& values)
+{
+	writeBinary(out, (uint64_t)values.size());
+	out.write((const char*)values.data(), sizeof(T) * values.size());
+}
+template<class T> bool readBinary(std::istream& in, vector<T>& values)
+{
+	uint64_t size;
+	if (!readBinary(in, size))
+		return false;
+	values.resize(size);
+	return (bool)in.read((char*)values.data(), sizeof(T) * size);
+}
+inline void writeBinary(std::ostream& out, const string& value)
+{
+	writeBinary(out, (uint64_t)value.size());
+	out.write(value.data(), value.size());
+}
+inline bool readBinary(std::istream& in, string& value)
+{
+	uint64_t size;
+	if (!readBinary(in, size))
+		return false;
+	value.resize(size);
+	return (bool)in.read(&value[0], size);
+}
+
 struct IterationStats
 {
     int sum_of_costs;
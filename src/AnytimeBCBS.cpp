@@ -59,7 +59,7 @@ void AnytimeBCBS::run()
         solution.resize(num_of_agents);
         bcbs.updatePaths(best_goal_node);
         for (int i = 0; i < num_of_agents; i++)
-            solution[i] = *bcbs.paths[i];
+            solution[i] = CompactPath(*bcbs.paths[i]);
     }
     bcbs.clearSearchEngines();
     cout << getSolverName() << ": Iterations = " << iteration_stats.size() << ", "
@@ -75,34 +75,37 @@ void AnytimeBCBS::validateSolution() const
     if (solution.empty())
         return;
     int N = instance.getDefaultNumberOfAgents();
+    vector<Path> paths(N);
+    for (int i = 0; i < N; i++)
+        solution[i].decode(paths[i]);
     for (int i = 0; i < N; i++)
     {
         for (int j = i + 1; j < N; j++)
         {
-            const auto a1 = solution[i].size() <= solution[j].size()? i : j;
-            const auto a2 = solution[i].size() <= solution[j].size()? j : i;
+            const auto a1 = paths[i].size() <= paths[j].size()? i : j;
+            const auto a2 = paths[i].size() <= paths[j].size()? j : i;
             int t = 1;
-            for (; t < (int) solution[a1].size(); t++)
+            for (; t < (int) paths[a1].size(); t++)
             {
-                if (solution[a1][t].location == solution[a2][t].location) // vertex conflict
+                if (paths[a1][t].location == paths[a2][t].location) // vertex conflict
                 {
                     cerr << "Find a vertex conflict between agents " << a1 << " and " << a2 <<
-                         " at location " << solution[a1][t].location << " at timestep " << t << endl;
+                         " at location " << paths[a1][t].location << " at timestep " << t << endl;
                     exit(-1);
                 }
-                else if (solution[a1][t].location == solution[a2][t - 1].location &&
-                        solution[a1][t - 1].location == solution[a2][t].location) // edge conflict
+                else if (paths[a1][t].location == paths[a2][t - 1].location &&
+                        paths[a1][t - 1].location == paths[a2][t].location) // edge conflict
                 {
                     cerr << "Find an edge conflict between agents " << a1 << " and " << a2 <<
-                         " at edge (" << solution[a1][t - 1].location << "," << solution[a1][t].location <<
+                         " at edge (" << paths[a1][t - 1].location << "," << paths[a1][t].location <<
                          ") at timestep " << t << endl;
                     exit(-1);
                 }
             }
-            int target = solution[a1].back().location;
-            for (; t < (int) solution[a2].size(); t++)
+            int target = paths[a1].back().location;
+            for (; t < (int) paths[a2].size(); t++)
             {
-                if (solution[a2][t].location == target)  // target conflict
+                if (paths[a2][t].location == target)  // target conflict
                 {
                     cerr << "Find a target conflict where agent " << a2 << " traverses agent " << a1 <<
                          "'s target location " << target << " at timestep " << t << endl;
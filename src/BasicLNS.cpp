@@ -1,4 +1,5 @@
 #include "BasicLNS.h"
+#include <sstream>
 BasicLNS::BasicLNS(const Instance& instance, double time_limit, int neighbor_size, int screen, const string & bandit_algorithm_name, int neighborhoodSizes, int numberOfDestroyHeuristics) :
         instance(instance), time_limit(time_limit), neighbor_size(neighbor_size), screen(screen), bandit_algorithm_name(bandit_algorithm_name), ucb1Constant(100), numberOfNeighborhoodSizeCandidates(neighborhoodSizes), numberOfDestroyHeuristics(numberOfDestroyHeuristics)
 {
@@ -68,7 +69,7 @@ int BasicLNS::sampleDestroyHeuristic(BanditStats* stats)
     const int numberOfArms = stats->destroy_weights.size();
     double weightSum = 0;
     double totalCount = 0;
-    double r = (double) rand() / RAND_MAX;
+    double r = std::generate_canonical<double, 32>(generator);
     double threshold = stats->destroy_weights[0];
     for (int index = 0; index < numberOfArms; index++) 
     {
@@ -77,7 +78,7 @@ int BasicLNS::sampleDestroyHeuristic(BanditStats* stats)
     }
     if(bandit_algorithm == RANDOM_BANDIT)
     {
-        stats->banditIndex = rand()%stats->destroy_weights.size();
+        stats->banditIndex = getRandomInt((int)stats->destroy_weights.size());
     }
     if(bandit_algorithm == ROULETTE_WHEEL)
     {
@@ -163,3 +164,108 @@ int BasicLNS::sampleDestroyHeuristic(BanditStats* stats)
     }
     return stats->banditIndex;
 }
+
+void BasicLNS::saveState(std::ostream& out) const
+{
+    writeBinary(out, sum_of_costs);
+    writeBinary(out, num_of_failures);
+    writeBinary(out, runtime);
+
+    // the algorithm names repeat, so the iterations refer to them by index
+    vector<string> algorithms;
+    vector<uint8_t> algorithm_ids;
+    algorithm_ids.reserve(iteration_stats.size());
+    for (const auto& stats : iteration_stats)
+    {
+        auto it = std::find(algorithms.begin(), algorithms.end(), stats.algorithm);
+        if (it == algorithms.end())
+            it = algorithms.insert(it, stats.algorithm);
+        algorithm_ids.push_back((uint8_t)(it - algorithms.begin()));
+    }
+    writeBinary(out, (uint64_t)algorithms.size());
+    for (const auto& algorithm : algorithms)
+        writeBinary(out, algorithm);
+    writeBinary(out, algorithm_ids);
+    for (const auto& stats : iteration_stats)
+    {
+        writeBinary(out, stats.num_of_agents);
+        writeBinary(out, stats.sum_of_costs);
+        writeBinary(out, stats.runtime);
+        writeBinary(out, stats.sum_of_costs_lowerbound);
+        writeBinary(out, stats.num_of_colliding_pairs);
+        writeBinary(out, stats.success);
+    }
+
+    saveBanditStats(out, heuristicBanditStats);
+    writeBinary(out, (uint64_t)neighborhoodBanditStats.size());
+    for (const auto stats : neighborhoodBanditStats)
+        saveBanditStats(out, *stats);
+
+    std::ostringstream engine;
+    engine << generator;
+    writeBinary(out, engine.str());
+}
+
+bool BasicLNS::loadState(std::istream& in)
+{
+    if (!readBinary(in, sum_of_costs) || !readBinary(in, num_of_failures) || !readBinary(in, runtime))
+        return false;
+
+    uint64_t num_of_algorithms;
+    if (!readBinary(in, num_of_algorithms))
+        return false;
+    vector<string> algorithms(num_of_algorithms);
+    for (auto& algorithm : algorithms)
+    {
+        if (!readBinary(in, algorithm))
+            return false;
+    }
+    vector<uint8_t> algorithm_ids;
+    if (!readBinary(in, algorithm_ids))
+        return false;
+    iteration_stats.clear();
+    for (auto id : algorithm_ids)
+    {
+        int num_of_agents, sum_of_costs_of_iteration, lowerbound, num_of_colliding_pairs, success;
+        double runtime_of_iteration;
+        if (id >= algorithms.size() || !readBinary(in, num_of_agents) || !readBinary(in, sum_of_costs_of_iteration) ||
+            !readBinary(in, runtime_of_iteration) || !readBinary(in, lowerbound) ||
+            !readBinary(in, num_of_colliding_pairs) || !readBinary(in, success))
+            return false;
+        iteration_stats.emplace_back(num_of_agents, sum_of_costs_of_iteration, runtime_of_iteration, algorithms[id],
+                                     lowerbound, num_of_colliding_pairs, success);
+    }
+
+    uint64_t num_of_neighborhood_bandits;
+    if (!loadBanditStats(in, heuristicBanditStats) || !readBinary(in, num_of_neighborhood_bandits) ||
+        num_of_neighborhood_bandits != neighborhoodBanditStats.size())
+        return false;
+    for (auto stats : neighborhoodBanditStats)
+    {
+        if (!loadBanditStats(in, *stats))
+            return false;
+    }
+
+    string engine;
+    if (!readBinary(in, engine))
+        return false;
+    std::istringstream(engine) >> generator;
+    return true;
+}
+
+void BasicLNS::saveBanditStats(std::ostream& out, const BanditStats& stats)
+{
+    writeBinary(out, stats.destroy_weights);
+    writeBinary(out, stats.destroy_weights_squared);
+    writeBinary(out, stats.destroy_counts);
+    writeBinary(out, stats.banditIndex);
+}
+
+bool BasicLNS::loadBanditStats(std::istream& in, BanditStats& stats)
+{
+    auto num_of_arms = stats.destroy_weights.size();
+    return readBinary(in, stats.destroy_weights) && readBinary(in, stats.destroy_weights_squared) &&
+        readBinary(in, stats.destroy_counts) && readBinary(in, stats.banditIndex) &&
+        stats.destroy_weights.size() == num_of_arms && stats.destroy_weights_squared.size() == num_of_arms &&
+        stats.destroy_counts.size() == num_of_arms;
+}
@@ -3,28 +3,15 @@
 #include <chrono>       // std::chrono::system_clock
 #include "CBS.h"
 #include "SIPP.h"
+#include "Profiler.h"
 #include "SpaceTimeAStar.h"
 
 
-// takes the paths_found_initially and UPDATE all (constrained) paths found for agents from curr to start
+// moves paths from paths_node to curr, touching only the agents replanned between the two CT nodes
 void CBS::updatePaths(CBSNode* curr)
 {
-	for (int i = 0; i < num_of_agents; i++)
-		paths[i] = &paths_found_initially[i];
-	vector<bool> updated(num_of_agents, false);  // initialized for false
-
-	while (curr != nullptr)
-	{
-		for (auto & path : curr->paths)
-		{
-			if (!updated[path.first])
-			{
-				paths[path.first] = &(path.second);
-				updated[path.first] = true;
-			}
-		}
-		curr = curr->parent;
-	}
+	switchPaths((const CBSNode*)paths_node, (const CBSNode*)curr, paths);
+	paths_node = curr;
 }
 
 void CBS::copyConflicts(const list<shared_ptr<Conflict >>& conflicts,
@@ -60,7 +47,7 @@ void CBS::findConflicts(HLNode& curr, int a1, int a2)
 		int loc2 = paths[a2]->at(timestep).location;
 		if (loc1 == loc2)
 		{
-			shared_ptr<Conflict> conflict(new Conflict());
+			auto conflict = make_shared<Conflict>();
 			if (target_reasoning && paths[a1]->size() == timestep + 1)
 			{
 				conflict->targetConflict(a1, a2, loc1, timestep);
@@ -81,7 +68,7 @@ void CBS::findConflicts(HLNode& curr, int a1, int a2)
 			&& loc1 == paths[a2]->at(timestep + 1).location
 			&& loc2 == paths[a1]->at(timestep + 1).location)
 		{
-			shared_ptr<Conflict> conflict(new Conflict());
+			auto conflict = make_shared<Conflict>();
 			conflict->edgeConflict(a1, a2, loc1, loc2, timestep + 1);
 			assert(!conflict->constraint1.empty());
 			assert(!conflict->constraint2.empty());
@@ -98,7 +85,7 @@ void CBS::findConflicts(HLNode& curr, int a1, int a2)
 			int loc2 = paths[a2_]->at(timestep).location;
 			if (loc1 == loc2)
 			{
-				shared_ptr<Conflict> conflict(new Conflict());
+				auto conflict = make_shared<Conflict>();
 				if (target_reasoning)
 					conflict->targetConflict(a1_, a2_, loc1, timestep);
 				else
@@ -114,7 +101,7 @@ void CBS::findConflicts(HLNode& curr, int a1, int a2)
 
 void CBS::findConflicts(HLNode& curr)
 {
-	clock_t t = clock();
+	auto t = Time::now();
 	if (curr.parent != nullptr)
 	{
 		// Copy from parent
@@ -153,7 +140,7 @@ void CBS::findConflicts(HLNode& curr)
 			}
 		}
 	}
-	runtime_detect_conflicts += (double)(clock() - t) / CLOCKS_PER_SEC;
+	runtime_detect_conflicts += ((fsec)(Time::now() - t)).count();
 }
 
 
@@ -273,8 +260,32 @@ void CBS::computeConflictPriority(shared_ptr<Conflict>& con, CBSNode& node)
 	}
 }
 
+void CBS::buildMDDsInParallel(HLNode& node, const vector<pair<int, size_t>>& agents)
+{
+	if (num_of_threads > 1 && (int)agents.size() >= MIN_PARALLEL_MDDS)
+		mdd_helper.buildMDDs(node, agents, num_of_threads);
+}
+
 void CBS::classifyConflicts(CBSNode &node)
 {
+	if (node.parent == nullptr && heuristic_helper.type != heuristics_type::ZERO)
+	{ // the root has many conflicts, so build the MDDs that classifying them needs in parallel first
+		vector<pair<int, size_t>> agents;
+		vector<bool> added(num_of_agents, false);
+		for (const auto& con : node.unknownConf)
+		{
+			int timestep = get<3>(con->constraint1.back());
+			for (int a : {con->a1, con->a2})
+			{
+				if (!added[a] && timestep < (int)paths[a]->size())
+				{
+					added[a] = true;
+					agents.emplace_back(a, paths[a]->size());
+				}
+			}
+		}
+		buildMDDsInParallel(node, agents);
+	}
 	// Classify all conflicts in unknownConf
 	while (!node.unknownConf.empty())
 	{
@@ -390,18 +401,18 @@ void CBS::removeLowPriorityConflicts(list<shared_ptr<Conflict>>& conflicts) cons
 
 bool CBS::findPathForSingleAgent(CBSNode*  node, int ag, int lowerbound)
 {
-	clock_t t = clock();
+	auto t = Time::now();
 	Path new_path = search_engines[ag]->findOptimalPath(*node, initial_constraints[ag], paths, ag, lowerbound);
 	runtime_build_CT += search_engines[ag]->runtime_build_CT;
 	runtime_build_CAT += search_engines[ag]->runtime_build_CAT;
-	runtime_path_finding += (double)(clock() - t) / CLOCKS_PER_SEC;
+	runtime_path_finding += ((fsec)(Time::now() - t)).count();
 	if (!new_path.empty())
 	{
 		assert(!isSamePath(*paths[ag], new_path));
-		node->paths.emplace_back(ag, new_path);
 		node->g_val = node->g_val - (int)paths[ag]->size() + (int)new_path.size();
-		paths[ag] = &node->paths.back().second;
 		node->makespan = max(node->makespan, new_path.size() - 1);
+		node->paths.emplace_back(ag, std::move(new_path), paths[ag]);
+		paths[ag] = node->paths.back().path.get();
 		return true;
 	}
 	else
@@ -412,7 +423,7 @@ bool CBS::findPathForSingleAgent(CBSNode*  node, int ag, int lowerbound)
 
 bool CBS::generateChild(CBSNode*  node, CBSNode* parent)
 {
-	clock_t t1 = clock();
+	auto t1 = Time::now();
 	node->parent = parent;
 	node->HLNode::parent = parent;
 	node->g_val = parent->g_val;
@@ -426,14 +437,14 @@ bool CBS::generateChild(CBSNode*  node, CBSNode* parent)
 		int lowerbound = (int)paths[agent]->size() - 1;
 		if (!findPathForSingleAgent(node, agent, lowerbound))
 		{
-			runtime_generate_child += (double)(clock() - t1) / CLOCKS_PER_SEC;
+			runtime_generate_child += ((fsec)(Time::now() - t1)).count();
 			return false;
 		}
 	}
 
 	findConflicts(*node);
 	heuristic_helper.computeQuickHeuristics(*node);
-	runtime_generate_child += (double)(clock() - t1) / CLOCKS_PER_SEC;
+	runtime_generate_child += ((fsec)(Time::now() - t1)).count();
 	return true;
 }
 
@@ -983,7 +994,7 @@ bool CBS::solve(double _time_limit, int _cost_lowerbound, int _cost_upperbound)
 		cout << name << ": ";
 	}
 	// set timer
-	start = clock();
+	start = Time::now();
 
 	if(solution_found) // continue searching
     {
@@ -996,6 +1007,7 @@ bool CBS::solve(double _time_limit, int _cost_lowerbound, int _cost_upperbound)
 
 	while (!cleanup_list.empty() && !solution_found)
 	{
+		PROFILE_SCOPE("CT node");
 		auto curr = selectNode();
         if (curr == nullptr)
             continue;
@@ -1012,9 +1024,9 @@ bool CBS::solve(double _time_limit, int _cost_lowerbound, int _cost_upperbound)
 
 		if (!curr->h_computed) // heuristics has not been computed yet
 		{
-			runtime = (double)(clock() - start) / CLOCKS_PER_SEC;
+			runtime = ((fsec)(Time::now() - start)).count();
 			bool succ = heuristic_helper.computeInformedHeuristics(*curr, time_limit - runtime);
-			runtime = (double)(clock() - start) / CLOCKS_PER_SEC;
+			runtime = ((fsec)(Time::now() - start)).count();
             heuristic_helper.updateOnlineHeuristicErrors(*curr);
             heuristic_helper.updateInadmissibleHeuristics(*curr); // compute inadmissible heuristics
 			if (!succ) // no solution, so prune this node
@@ -1042,7 +1054,7 @@ bool CBS::solve(double _time_limit, int _cost_lowerbound, int _cost_upperbound)
                 return solution_found;
             }
 			foundBypass = false;
-			CBSNode* child[2] = { new CBSNode() , new CBSNode() };
+			CBSNode* child[2] = { node_pool.create(), node_pool.create() };
 
 			curr->conflict = chooseConflict(*curr);
 
@@ -1062,7 +1074,7 @@ bool CBS::solve(double _time_limit, int _cost_lowerbound, int _cost_upperbound)
 				solved[i] = generateChild(child[i], curr);
 				if (!solved[i])
 				{
-					delete (child[i]);
+					node_pool.recycle(child[i]);
 					continue;
 				}
 				else if (bypass && child[i]->g_val == curr->g_val && child[i]->distance_to_go < curr->distance_to_go) // Bypass1
@@ -1075,25 +1087,7 @@ bool CBS::solve(double _time_limit, int _cost_lowerbound, int _cost_upperbound)
 					curr->unknownConf = child[i]->unknownConf;
 					curr->distance_to_go = child[i]->distance_to_go;
 					curr->conflict = nullptr;
-					for (const auto& path : child[i]->paths) // update paths
-					{
-						auto p = curr->paths.begin();
-						while (p != curr->paths.end())
-						{
-							if (path.first == p->first)
-							{
-								p->second = path.second;
-								paths[p->first] = &p->second;
-								break;
-							}
-							++p;
-						}
-						if (p == curr->paths.end())
-						{
-							curr->paths.emplace_back(path);
-							paths[path.first] = &curr->paths.back().second;
-						}
-					}
+					adoptPaths(curr, child[i], paths);
 					if (screen > 1)
 					{
 						cout << "	Update " << *curr << endl;
@@ -1105,7 +1099,7 @@ bool CBS::solve(double _time_limit, int _cost_lowerbound, int _cost_upperbound)
 			{
 				for (auto & i : child)
 				{
-					delete i;
+					node_pool.recycle(i);
 					i = nullptr;
 				}
                 if (PC)
@@ -1113,6 +1107,7 @@ bool CBS::solve(double _time_limit, int _cost_lowerbound, int _cost_upperbound)
 			}
 			else
 			{
+				paths = copy; // paths belong to curr again
 				for (int i = 0; i < 2; i++)
 				{
 					if (solved[i])
@@ -1170,7 +1165,7 @@ bool CBS::terminate(HLNode* curr)
             printResults();
 		return true;
 	}
-	runtime = (double)(clock() - start) / CLOCKS_PER_SEC;
+	runtime = ((fsec)(Time::now() - start)).count();
 	if (curr->conflicts.empty() && curr->unknownConf.empty()) //no conflicts
 	{// found a solution
 		solution_found = true;
@@ -1186,7 +1181,7 @@ bool CBS::terminate(HLNode* curr)
 			printResults();
 		return true;
 	}
-	if (runtime > time_limit || num_HL_expanded > node_limit)
+	if (runtime > time_limit || num_HL_expanded > node_limit || isInterrupted())
 	{   // time/node out
 		solution_cost = -1;
 		solution_found = false;
@@ -1202,7 +1197,7 @@ void CBS::addConstraints(const HLNode* curr, HLNode* child1, HLNode* child2) con
 {
 	if (disjoint_splitting && curr->conflict->type == conflict_type::STANDARD)
 	{
-		int first = (bool)(rand() % 2);
+		int first = (bool)(random_engine() % 2);
 		if (first) // disjoint splitting on the first agent
 		{
 			child1->constraints = curr->conflict->constraint1;
@@ -1284,7 +1279,7 @@ CBS::CBS(const Instance& instance, bool sipp, int screen) :
 	corridor_helper(search_engines, initial_constraints),
 	heuristic_helper(instance.getDefaultNumberOfAgents(), paths, search_engines, initial_constraints, mdd_helper)
 {
-	clock_t t = clock();
+	auto t = Time::now();
 
     search_engines.resize(num_of_agents);
     initial_constraints.reserve(num_of_agents);
@@ -1298,7 +1293,7 @@ CBS::CBS(const Instance& instance, bool sipp, int screen) :
         initial_constraints.emplace_back(instance.num_of_cols, instance.map_size);
     }
     mutex_helper.search_engines = search_engines;
-	runtime_preprocessing = (double)(clock() - t) / CLOCKS_PER_SEC;
+	runtime_preprocessing = ((fsec)(Time::now() - t)).count();
 
 	if (screen >= 2) // print start and goals
 	{
@@ -1318,16 +1313,14 @@ vector<int> CBS::shuffleAgents() const
 
 	if (randomRoot)
 	{
-		std::random_device rd;
-		std::mt19937 g(rd());
-		std::shuffle(std::begin(agents), std::end(agents), g);
+		std::shuffle(std::begin(agents), std::end(agents), random_engine);
 	}
 	return agents;
 }
 
 bool CBS::generateRoot()
 {
-	auto root = new CBSNode();
+	auto root = node_pool.create();
 	root->g_val = 0;
 	paths.resize(num_of_agents, nullptr);
 
@@ -1348,9 +1341,7 @@ bool CBS::generateRoot()
 
 		if (randomRoot)
 		{
-			std::random_device rd;
-			std::mt19937 g(rd());
-			std::shuffle(std::begin(agents), std::end(agents), g);
+			std::shuffle(std::begin(agents), std::end(agents), random_engine);
 		}
 
 		for (auto i : agents)
@@ -1359,14 +1350,14 @@ bool CBS::generateRoot()
 			if (paths_found_initially[i].empty())
 			{
 				cout << "No path exists for agent " << i << endl;
-                delete root;
+                node_pool.recycle(root);
 				return false;
 			}
-            runtime = (double)(clock() - start) / CLOCKS_PER_SEC;
-            if (runtime > time_limit)
+            runtime = ((fsec)(Time::now() - start)).count();
+            if (runtime > time_limit || isInterrupted())
             {
                 cout << "Time out when generating the root CT node" << endl;
-                delete root;
+                node_pool.recycle(root);
                 return false;
             }
 			paths[i] = &paths_found_initially[i];
@@ -1386,6 +1377,7 @@ bool CBS::generateRoot()
 
 	root->h_val = 0;
 	root->depth = 0;
+	paths_node = root;
 	findConflicts(*root);
 	heuristic_helper.computeQuickHeuristics(*root);
 	pushNode(root);
@@ -1403,9 +1395,8 @@ inline void CBS::releaseNodes()
 	open_list.clear();
 	cleanup_list.clear();
 	focal_list.clear();
-	for (auto& node : allNodes_table)
-		delete node;
 	allNodes_table.clear();
+	node_pool.release();
 }
 
 CBS::~CBS()
@@ -1497,6 +1488,7 @@ void CBS::clear()
 	releaseNodes();
 	paths.clear();
 	paths_found_initially.clear();
+	paths_node = nullptr;
 	dummy_start = nullptr;
 	goal_node = nullptr;
 	solution_found = false;
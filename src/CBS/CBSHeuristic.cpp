@@ -1,6 +1,7 @@
 #include "CBSHeuristic.h"
 #include "CBS.h"
 #include <queue>
+#include "Profiler.h"
 
 void CBSHeuristic::updateInadmissibleHeuristics(HLNode& curr)
 {
@@ -181,9 +182,10 @@ void CBSHeuristic::computeQuickHeuristics(HLNode& node)
 
 bool CBSHeuristic::computeInformedHeuristics(CBSNode& curr, double _time_limit)
 {
+    PROFILE_SCOPE("CT node heuristic");
     curr.h_computed = true;
 	// create conflict graph
-	start_time = clock();
+	start_time = Time::now();
 	this->time_limit = _time_limit;
 	int num_of_CGedges;
 	vector<int> HG(num_of_agents * num_of_agents, 0); // heuristic graph
@@ -198,21 +200,13 @@ bool CBSHeuristic::computeInformedHeuristics(CBSNode& curr, double _time_limit)
 	case heuristics_type::CG:
 		buildCardinalConflictGraph(curr, HG, num_of_CGedges);
 		// Minimum Vertex Cover
-		if (curr.parent == nullptr || num_of_CGedges > ILP_edge_threshold || // root node of CBS tree or the graph is too large
-            target_reasoning || disjoint_splitting) // when we are allowed to replan for multiple agents, the incremental method is not correct any longer.
-            h = minimumVertexCover(HG);
-		else
-			h = minimumVertexCover(HG, curr.parent->h_val, num_of_agents, num_of_CGedges);
+		h = minimumVertexCover(HG);
 		break;
 	case heuristics_type::DG:
 		if (!buildDependenceGraph(curr, HG, num_of_CGedges))
 			return false;
 		// Minimum Vertex Cover
-		if (curr.parent == nullptr || num_of_CGedges > ILP_edge_threshold || // root node of CBS tree or the graph is too large
-            target_reasoning || disjoint_splitting) // when we are allowed to replan for multiple agents, the incremental method is not correct any longer.
-            h = minimumVertexCover(HG);
-		else
-			h = minimumVertexCover(HG, curr.parent->h_val, num_of_agents, num_of_CGedges);
+		h = minimumVertexCover(HG);
 		break;
 	case heuristics_type::WDG:
 		if (!buildWeightedDependencyGraph(curr, HG))
@@ -231,9 +225,10 @@ bool CBSHeuristic::computeInformedHeuristics(CBSNode& curr, double _time_limit)
 
 bool CBSHeuristic::computeInformedHeuristics(ECBSNode& curr, const vector<int>& min_f_vals, double _time_limit)
 {
+    PROFILE_SCOPE("CT node heuristic");
     curr.h_computed = true;
 	// create conflict graph
-	start_time = clock();
+	start_time = Time::now();
 	this->time_limit = _time_limit;
 	int num_of_CGedges;
 	vector<int> HG(num_of_agents * num_of_agents, 0); // heuristic graph
@@ -280,7 +275,7 @@ void CBSHeuristic::buildCardinalConflictGraph(CBSNode& curr, vector<int>& CG, in
 			}
 		}
 	}
-	runtime_build_dependency_graph += (double)(clock() - start_time) / CLOCKS_PER_SEC;
+	runtime_build_dependency_graph += ((fsec)(Time::now() - start_time)).count();
 }
 
 
@@ -313,9 +308,9 @@ bool CBSHeuristic::buildDependenceGraph(CBSNode& node, vector<int>& CG, int& num
             CG[idx] = dependent(a1, a2, node)? 1 : 0;
             CG[a2 * num_of_agents + a1] = CG[idx];
             lookupTable[a1][a2][HTableEntry(a1, a2, &node)] = make_tuple(CG[idx], 1, 0);
-            if ((clock() - start_time) / CLOCKS_PER_SEC > time_limit) // run out of time
+            if (((fsec)(Time::now() - start_time)).count() > time_limit) // run out of time
             {
-                runtime_build_dependency_graph += (double)(clock() - start_time) / CLOCKS_PER_SEC;
+                runtime_build_dependency_graph += ((fsec)(Time::now() - start_time)).count();
                 return false;
             }
         }
@@ -325,7 +320,7 @@ bool CBSHeuristic::buildDependenceGraph(CBSNode& node, vector<int>& CG, int& num
 			conflict->priority = conflict_priority::PSEUDO_CARDINAL; // the two agents are dependent, although resolving this conflict might not increase the cost
 		}
 	}
-	runtime_build_dependency_graph += (double)(clock() - start_time) / CLOCKS_PER_SEC;
+	runtime_build_dependency_graph += ((fsec)(Time::now() - start_time)).count();
 	return true;
 }
 
@@ -374,9 +369,9 @@ bool CBSHeuristic::buildWeightedDependencyGraph(CBSNode& node, vector<int>& CG)
 				CG[a2 * num_of_agents + a1] = 0;
 			}
 		}
-		if ((clock() - start_time) / CLOCKS_PER_SEC > time_limit) // run out of time
+		if (((fsec)(Time::now() - start_time)).count() > time_limit) // run out of time
 		{
-			runtime_build_dependency_graph += (double)(clock() - start_time) / CLOCKS_PER_SEC;
+			runtime_build_dependency_graph += ((fsec)(Time::now() - start_time)).count();
 			return false;
 		}
 		if (CG[idx] == MAX_COST) // no solution
@@ -389,7 +384,7 @@ bool CBSHeuristic::buildWeightedDependencyGraph(CBSNode& node, vector<int>& CG)
 		}
 	}
 
-	runtime_build_dependency_graph += (double)(clock() - start_time) / CLOCKS_PER_SEC;
+	runtime_build_dependency_graph += ((fsec)(Time::now() - start_time)).count();
 	return true;
 }
 
@@ -426,9 +421,9 @@ bool CBSHeuristic::buildWeightedDependencyGraph(ECBSNode& node, const vector<int
 		{
 			auto rst = solve2Agents(a1, a2, node);
             lookupTable[a1][a2][HTableEntry(a1, a2, &node)] = rst;
-            if ((clock() - start_time) / CLOCKS_PER_SEC > time_limit) // run out of time
+            if (((fsec)(Time::now() - start_time)).count() > time_limit) // run out of time
             {
-                runtime_build_dependency_graph += (double)(clock() - start_time) / CLOCKS_PER_SEC;
+                runtime_build_dependency_graph += ((fsec)(Time::now() - start_time)).count();
                 return false;
             }
             CG[idx]  = get<0>(rst);
@@ -478,9 +473,9 @@ bool CBSHeuristic::buildWeightedDependencyGraph(ECBSNode& node, const vector<int
         {
             auto rst = solve2Agents(a1, a2, node);
             lookupTable[a1][a2][HTableEntry(a1, a2, &node)] = rst;
-            if ((clock() - start_time) / CLOCKS_PER_SEC > time_limit) // run out of time
+            if (((fsec)(Time::now() - start_time)).count() > time_limit) // run out of time
             {
-                runtime_build_dependency_graph += (double)(clock() - start_time) / CLOCKS_PER_SEC;
+                runtime_build_dependency_graph += ((fsec)(Time::now() - start_time)).count();
                 return false;
             }
             CG[idx]  = get<0>(rst);
@@ -502,7 +497,7 @@ bool CBSHeuristic::buildWeightedDependencyGraph(ECBSNode& node, const vector<int
         if (CG[idx] == MAX_COST) // no solution
             return false;
     }
-	runtime_build_dependency_graph += (double)(clock() - start_time) / CLOCKS_PER_SEC;
+	runtime_build_dependency_graph += ((fsec)(Time::now() - start_time)).count();
 	return true;
 }
 
@@ -529,7 +524,7 @@ pair<int, int> CBSHeuristic::solve2Agents(int a1, int a2, const CBSNode& node, b
 	cbs.setHighLevelSolver(high_level_solver_type::ASTAR, 1); // solve the sub problem optimally
 	cbs.setNodeLimit(node_limit);
 
-	double runtime = (double)(clock() - start_time) / CLOCKS_PER_SEC;
+	double runtime = ((fsec)(Time::now() - start_time)).count();
 	int root_g = (int)initial_paths[0].size() - 1 + (int)initial_paths[1].size() - 1;
 	int lowerbound = root_g;
 	int upperbound = MAX_COST;
@@ -580,7 +575,7 @@ tuple<int, int, int> CBSHeuristic::solve2Agents(int a1, int a2, const ECBSNode&
 	cbs.setHighLevelSolver(high_level_solver_type::ASTAR, 1); // solve the sub problem optimally
 	cbs.setNodeLimit(node_limit);
 
-	double runtime = (double)(clock() - start_time) / CLOCKS_PER_SEC;
+	double runtime = ((fsec)(Time::now() - start_time)).count();
 	cbs.solve(time_limit - runtime, 0, MAX_COST);
 	num_solve_2agent_problems++;
 	
@@ -602,7 +597,7 @@ tuple<int, int, int> CBSHeuristic::solve2Agents(int a1, int a2, const ECBSNode&
 
 int CBSHeuristic::minimumVertexCover(const vector<int>& CG)
 {
-	clock_t t = clock();
+	auto t = Time::now();
 	int rst = 0;
 	std::vector<bool> done(num_of_agents, false);
 	for (int i = 0; i < num_of_agents; i++)
@@ -638,137 +633,171 @@ int CBSHeuristic::minimumVertexCover(const vector<int>& CG)
 			continue;
 		}
 
-		std::vector<int> subgraph(indices.size()  * indices.size(), 0);
-		int num_edges = 0;
-		for (int j = 0; j < (int) indices.size(); j++)
+		int num = (int)indices.size();
+		std::vector<int> subgraph(num * num, 0);
+		for (int j = 0; j < num; j++)
 		{
-			for (int k = j + 1; k < (int)indices.size(); k++)
+			for (int k = j + 1; k < num; k++)
 			{
-				subgraph[j * indices.size() + k] = CG[indices[j] * num_of_agents + indices[k]];
-				subgraph[k * indices.size() + j] = CG[indices[k] * num_of_agents + indices[j]];
-				if (subgraph[j * indices.size() + k] > 0)
-					num_edges++;
+				if (CG[indices[j] * num_of_agents + indices[k]] > 0 || CG[indices[k] * num_of_agents + indices[j]] > 0)
+					subgraph[j * num + k] = 1;
 			}
 		}
-
-		if (num_edges > ILP_edge_threshold)
+		getComponentKey(subgraph, num, false, mvc_key);
+		auto got = mvc_memo.find(mvc_key);
+		if (got != mvc_memo.end())
 		{
-			rst += greedyMatching(subgraph, (int)indices.size());
-			double runtime = (double)(clock() - start_time) / CLOCKS_PER_SEC;
-			if (runtime > time_limit)
-				return -1; // run out of time
-		}
-		else
-		{
-			for (int k = 1; i < (int)indices.size(); k++)
-			{
-				if (KVertexCover(subgraph, (int)indices.size(), num_edges, i=k, (int)indices.size()))
-				{
-					rst += k;
-					break;
-				}
-				double runtime = (double)(clock() - start_time) / CLOCKS_PER_SEC;
-				if (runtime > time_limit)
-					return -1; // run out of time
-			}
+			rst += got->second;
+			continue;
 		}
+		int mvc = (num <= MAX_BITSET_MVC_NODES) ? bitsetVertexCover(subgraph, num) : greedyMatching(subgraph, num);
+		double runtime = ((fsec)(Time::now() - start_time)).count();
+		if (mvc < 0 || runtime > time_limit)
+			return -1; // run out of time
+		memoizeMVC(mvc);
+		rst += mvc;
 	}
 	num_solve_MVC++;
-	runtime_solve_MVC += (double)(clock() - t) / CLOCKS_PER_SEC;
+	runtime_solve_MVC += ((fsec)(Time::now() - t)).count();
 	return rst;
 }
 
-int CBSHeuristic::minimumVertexCover(const std::vector<int>& CG, int old_mvc, int cols, int num_of_CGedges)
+// exact minimum vertex cover of a component with at most 64 nodes (G[j * num + k] > 0 for edges with j < k),
+// or -1 if it runs out of time
+int CBSHeuristic::bitsetVertexCover(const vector<int>& G, int num)
 {
-	clock_t t = clock();
-	int rst = 0;
-	if (num_of_CGedges < 2)
-		return num_of_CGedges;
-	// Compute #CG nodes that have edges
-	int num_of_CGnodes = 0;
-	for (int i = 0; i <  cols; i++)
+	assert(num <= MAX_BITSET_MVC_NODES);
+	uint64_t adj[MAX_BITSET_MVC_NODES] = {};
+	for (int j = 0; j < num; j++)
 	{
-		for (int j = 0; j <  cols; j++)
+		for (int k = j + 1; k < num; k++)
 		{
-			if (CG[i * cols + j] > 0)
+			if (G[j * num + k] > 0)
 			{
-				num_of_CGnodes++;
-				break;
+				adj[j] |= uint64_t(1) << k;
+				adj[k] |= uint64_t(1) << j;
 			}
 		}
 	}
+	uint64_t vertices = (num == 64) ? ~uint64_t(0) : (uint64_t(1) << num) - 1;
+	return branchVertexCover(adj, vertices, num); // any num - 1 nodes cover a connected graph
+}
 
-	if (old_mvc == -1)
+// branch and bound on the subgraph induced by vertices.
+// return its minimum vertex cover if it is smaller than upper_bound, a value >= upper_bound otherwise,
+// and -1 if it runs out of time
+int CBSHeuristic::branchVertexCover(const uint64_t* adj, uint64_t vertices, int upper_bound)
+{
+	if ((++num_of_MVC_branches & 1023) == 0 && ((fsec)(Time::now() - start_time)).count() > time_limit)
+		return -1;
+
+	// remove isolated vertices, and take the neighbor of each vertex of degree one
+	int size = 0;
+	for (bool reduced = true; reduced;)
 	{
-		for (int i = 1; i < num_of_CGnodes; i++)
+		reduced = false;
+		for (auto rest = vertices; rest != 0; rest &= rest - 1)
 		{
-			if (KVertexCover(CG, num_of_CGnodes, num_of_CGedges, i, cols))
+			int v = __builtin_ctzll(rest);
+			if (!(vertices >> v & 1)) // removed in this pass
+				continue;
+			uint64_t neighbors = adj[v] & vertices;
+			if (neighbors == 0)
+				vertices &= ~(uint64_t(1) << v);
+			else if ((neighbors & (neighbors - 1)) == 0)
 			{
-				rst = i;
-				break;
+				vertices &= ~((uint64_t(1) << v) | neighbors);
+				size++;
+				reduced = true;
 			}
 		}
-        assert(rst>0);
 	}
-	else
+	if (vertices == 0 || size >= upper_bound)
+		return size;
+
+	// solve the connected components separately
+	uint64_t component = vertices & (~vertices + 1);
+	for (uint64_t frontier = component; frontier != 0;)
 	{
-		if (KVertexCover(CG, num_of_CGnodes, num_of_CGedges, old_mvc - 1, cols))
-			rst = old_mvc - 1;
-		else if (KVertexCover(CG, num_of_CGnodes, num_of_CGedges, old_mvc, cols))
-			rst = old_mvc;
-		else
-			rst = old_mvc + 1;
+		uint64_t next = 0;
+		for (auto rest = frontier; rest != 0; rest &= rest - 1)
+			next |= adj[__builtin_ctzll(rest)];
+		frontier = next & vertices & ~component;
+		component |= frontier;
+	}
+	if (component != vertices)
+	{
+		int rst1 = branchVertexCover(adj, component, upper_bound - size);
+		if (rst1 < 0)
+			return -1;
+		int rst2 = branchVertexCover(adj, vertices & ~component, upper_bound - size - rst1);
+		return rst2 < 0 ? -1 : size + rst1 + rst2;
 	}
-	num_solve_MVC++;
-	runtime_solve_MVC += (double)(clock() - t) / CLOCKS_PER_SEC;
-	return rst;
-}
 
-// Whether there exists a k-vertex cover solution
-bool CBSHeuristic::KVertexCover(const std::vector<int>& CG, int num_of_CGnodes, int num_of_CGedges, int k, int cols)
-{
-	double runtime = (double)(clock() - start_time) / CLOCKS_PER_SEC;
-	if (runtime > time_limit)
-		return true; // run out of time
-	if (num_of_CGedges == 0)
-		return true;
-	else if (num_of_CGedges > k * num_of_CGnodes - k)
-		return false;
+	// a greedy matching is a lower bound
+	int matching = 0;
+	for (uint64_t unmatched = vertices; unmatched != 0;)
+	{
+		int v = __builtin_ctzll(unmatched);
+		unmatched &= ~(uint64_t(1) << v);
+		uint64_t neighbors = adj[v] & unmatched;
+		if (neighbors != 0)
+		{
+			unmatched &= ~(neighbors & (~neighbors + 1));
+			matching++;
+		}
+	}
+	if (size + matching >= upper_bound)
+		return size + matching;
 
-	std::vector<int> node(2);
-	bool flag = true;
-	for (int i = 0; i < cols - 1 && flag; i++) // to find an edge
+	// branch on a vertex v of the maximum degree: either v or all its neighbors are in the cover
+	int v = -1, degree = 0;
+	for (auto rest = vertices; rest != 0; rest &= rest - 1)
 	{
-		for (int j = i + 1; j < cols && flag; j++)
+		int u = __builtin_ctzll(rest);
+		int d = __builtin_popcountll(adj[u] & vertices);
+		if (d > degree)
 		{
-			if (CG[i * cols + j] > 0)
-			{
-				node[0] = i;
-				node[1] = j;
-				flag = false;
-			}
+			v = u;
+			degree = d;
 		}
 	}
-	for (int i = 0; i < 2; i++)
+	int best = upper_bound - size;
+	int rst = branchVertexCover(adj, vertices & ~(uint64_t(1) << v), best - 1);
+	if (rst < 0)
+		return -1;
+	best = min(best, rst + 1);
+	rst = branchVertexCover(adj, vertices & ~(adj[v] | (uint64_t(1) << v)), best - degree);
+	if (rst < 0)
+		return -1;
+	best = min(best, rst + degree);
+	return size + best;
+}
+
+void CBSHeuristic::getComponentKey(const vector<int>& G, int num, bool weighted, vector<int>& key)
+{
+	key.clear();
+	key.push_back(weighted);
+	key.push_back(num);
+	for (int j = 0; j < num; j++)
 	{
-		std::vector<int> CG_copy(CG.size());
-		CG_copy.assign(CG.cbegin(), CG.cend());
-		int num_of_CGedges_copy = num_of_CGedges;
-		for (int j = 0; j < cols; j++)
+		for (int k = j + 1; k < num; k++)
 		{
-			if (CG_copy[node[i] * cols + j] > 0)
+			if (G[j * num + k] > 0)
 			{
-				CG_copy[node[i] * cols + j] = 0;
-				CG_copy[j * cols + node[i]] = 0;
-				num_of_CGedges_copy--;
+				key.push_back(j * num + k);
+				key.push_back(G[j * num + k]);
 			}
 		}
-		if (KVertexCover(CG_copy, num_of_CGnodes - 1, num_of_CGedges_copy, k - 1, cols))
-			return true;
 	}
-	return false;
 }
 
+void CBSHeuristic::memoizeMVC(int value)
+{
+	if (mvc_memo.size() >= MAX_MVC_MEMO_SIZE)
+		mvc_memo.clear();
+	mvc_memo[mvc_key] = value;
+}
 
 int CBSHeuristic::greedyMatching(const std::vector<int>& CG,  int cols)
 {
@@ -828,10 +857,10 @@ int CBSHeuristic::greedyWeightedMatching(const std::vector<int>& CG,  int cols)
 
 int CBSHeuristic::minimumWeightedVertexCover(const vector<int>& HG)
 {
-	clock_t t = clock();
+	auto t = Time::now();
 	int rst = weightedVertexCover(HG);
 	num_solve_MVC++;
-	runtime_solve_MVC += (double)(clock() - t) / CLOCKS_PER_SEC;
+	runtime_solve_MVC += ((fsec)(Time::now() - t)).count();
 	return rst;
 }
 
@@ -896,19 +925,35 @@ int CBSHeuristic::weightedVertexCover(const std::vector<int>& CG)
 				G[j * num + k] = std::max(CG[indices[j] * num_of_agents + indices[k]], CG[indices[k] * num_of_agents + indices[j]]);
 			}
 		}
-		if (num > ILP_node_threshold)
+		getComponentKey(G, num, true, mvc_key);
+		auto got = mvc_memo.find(mvc_key);
+		if (got != mvc_memo.end())
 		{
-		    rst += greedyWeightedMatching(G, num);
+			rst += got->second;
+			continue;
+		}
+		int value;
+		if (*std::max_element(range.begin(), range.end()) <= 1 && num <= MAX_BITSET_MVC_NODES) // unweighted
+		{
+			value = bitsetVertexCover(G, num);
+		}
+		else if (num > ILP_node_threshold)
+		{
+		    value = greedyWeightedMatching(G, num);
+			if (num <= MAX_BITSET_MVC_NODES) // the mvc of the unweighted graph is a lower bound as well
+				value = std::max(value, bitsetVertexCover(G, num));
 		}
 		else
 		{
 			std::vector<int> x(num);
 			int best_so_far = MAX_COST;
-			rst += DPForWMVC(x, 0, 0, G, range, best_so_far);
+			value = DPForWMVC(x, 0, 0, G, range, best_so_far);
 		}
-		double runtime = (double)(clock() - start_time) / CLOCKS_PER_SEC;
-		if (runtime > time_limit)
+		double runtime = ((fsec)(Time::now() - start_time)).count();
+		if (value < 0 || runtime > time_limit)
 			return -1; // run out of time
+		memoizeMVC(value);
+		rst += value;
 	}
 
 	return rst;
@@ -920,7 +965,7 @@ int CBSHeuristic::DPForWMVC(std::vector<int>& x, int i, int sum, const std::vect
 {
 	if (sum >= best_so_far)
 		return MAX_COST;
-	double runtime = (double)(clock() - start_time) / CLOCKS_PER_SEC;
+	double runtime = ((fsec)(Time::now() - start_time)).count();
 	if (runtime > time_limit)
 		return -1; // run out of time
 	else if (i == (int)x.size())
@@ -975,7 +1020,7 @@ int CBSHeuristic::DPForConstrainedWMVC(std::vector<bool>& x, int i, int sum, con
 {
 	if (sum >= best_so_far)
 		return INT_MAX;
-	double runtime = (double)(clock() - start_time) / CLOCKS_PER_SEC;
+	double runtime = ((fsec)(Time::now() - start_time)).count();
 	if (runtime > time_limit)
 		return -1; // run out of time
 	else if (i == (int)x.size())
@@ -1036,74 +1081,101 @@ bool CBSHeuristic::dependent(int a1, int a2, HLNode& node) // return true if the
 }
 
 // return true if the joint MDD exists.
+// For each node of mdd, the nodes of other at the same level that can coexist with it are kept as a bitset
+// over the level, so the children of all coexisting nodes are collected by ORing their child masks.
 bool CBSHeuristic::SyncMDDs(const MDD &mdd, const MDD& other) // assume mdd.levels <= other.levels
 {
 	if (other.levels.size() <= 1) // Either of the MDDs was already completely pruned already
 		return false;
+	typedef uint64_t Word;
+	const int W = 64;
+	for (const auto& level : mdd.levels)
+	{
+		int i = 0;
+		for (auto node : level)
+			node->index = i++;
+	}
+	for (const auto& level : other.levels)
+	{
+		int i = 0;
+		for (auto node : level)
+			node->index = i++;
+	}
+	int last_level = (int)mdd.levels.size() - 1; // mdd waits at its goal after its last level
 
-	SyncMDD copy(mdd);
-	if (copy.levels.size() < other.levels.size())
+	// all nodes coexist on level zero because agent starting points never collide
+	vector<Word> coexisting(1, 1), next_coexisting, child_masks, mask;
+	list<MDDNode*> wait; // the only child of a node of mdd after its last level
+	vector<pair<int, int>> next_locations; // (location, index) of the nodes of other at the next level
+	for (int t = 0; t + 1 < (int)other.levels.size(); t++)
 	{
-		size_t i = copy.levels.size();
-		copy.levels.resize(other.levels.size());
-		for (; i < copy.levels.size(); i++)
+		int words = ((int)other.levels[t].size() + W - 1) / W;
+		int next_words = ((int)other.levels[t + 1].size() + W - 1) / W;
+		child_masks.assign(other.levels[t].size() * next_words, 0);
+		for (auto v : other.levels[t])
 		{
-			SyncMDDNode* parent = copy.levels[i - 1].front();
-			auto node = new SyncMDDNode(parent->location, parent);
-			parent->children.push_back(node);
-			copy.levels[i].push_back(node);
-
+			for (auto child : v->children)
+				child_masks[v->index * next_words + child->index / W] |= Word(1) << (child->index % W);
 		}
-	}
-	// Cheaply find the coexisting nodes on level zero - all nodes coexist because agent starting points never collide
-	copy.levels[0].front()->coexistingNodesFromOtherMdds.push_back(other.levels[0].front());
+		next_locations.clear();
+		for (auto v : other.levels[t + 1])
+			next_locations.emplace_back(v->location, v->index);
+		std::sort(next_locations.begin(), next_locations.end());
+		auto findNext = [&](int location)
+		{
+			auto it = std::lower_bound(next_locations.begin(), next_locations.end(), make_pair(location, -1));
+			return (it != next_locations.end() && it->first == location) ? it->second : -1;
+		};
 
-	// what if level.size() = 1?
-	for (size_t i = 1; i < copy.levels.size(); i++)
-	{
-		for (auto node = copy.levels[i].begin(); node != copy.levels[i].end();)
+		const auto& curr_level = mdd.levels[min(t, last_level)];
+		next_coexisting.assign(mdd.levels[min(t + 1, last_level)].size() * next_words, 0);
+		mask.resize(next_words);
+		bool found = false;
+		for (auto u : curr_level)
 		{
-			// Go over all the node's parents and test their coexisting nodes' children for co-existance with this node
-			for (auto parent = (*node)->parents.begin(); parent != (*node)->parents.end(); parent++)
+			const Word* u_coexisting = &coexisting[u->index * words];
+			if (t >= last_level)
+				wait.assign(1, u);
+			const auto& u_children = (t < last_level) ? u->children : wait;
+			for (auto u_child : u_children)
 			{
-				//bool validParent = false;
-				for (const MDDNode* parentCoexistingNode : (*parent)->coexistingNodesFromOtherMdds)
+				std::fill(mask.begin(), mask.end(), 0);
+				for (auto v : other.levels[t])
 				{
-					for (const MDDNode* childOfParentCoexistingNode : parentCoexistingNode->children)
+					if (!(u_coexisting[v->index / W] >> (v->index % W) & 1))
+						continue;
+					const Word* v_children = &child_masks[v->index * next_words];
+					if (v->location == u_child->location) // skip the child of v that swaps with u
 					{
-						if ((*node)->location == childOfParentCoexistingNode->location ||// vertex conflict
-							((*node)->location == parentCoexistingNode->location && (*parent)->location == childOfParentCoexistingNode->location)) // edge conflict
-							continue;
-
-						auto it = (*node)->coexistingNodesFromOtherMdds.cbegin();
-						for (; it != (*node)->coexistingNodesFromOtherMdds.cend(); ++it)
-						{
-							if (*it == childOfParentCoexistingNode)
-								break;
-						}
-						if (it == (*node)->coexistingNodesFromOtherMdds.cend())
+						int swap = -1;
+						for (auto v_child : v->children)
 						{
-							(*node)->coexistingNodesFromOtherMdds.push_back(childOfParentCoexistingNode);
+							if (v_child->location == u->location)
+								swap = v_child->index;
 						}
+						for (int k = 0; k < next_words; k++)
+							mask[k] |= (swap >= 0 && swap / W == k) ? v_children[k] & ~(Word(1) << (swap % W)) : v_children[k];
+					}
+					else
+					{
+						for (int k = 0; k < next_words; k++)
+							mask[k] |= v_children[k];
 					}
 				}
+				int vertex = findNext(u_child->location); // the child of other at the same location
+				if (vertex >= 0)
+					mask[vertex / W] &= ~(Word(1) << (vertex % W));
+				Word* child_coexisting = &next_coexisting[u_child->index * next_words];
+				for (int k = 0; k < next_words; k++)
+				{
+					child_coexisting[k] |= mask[k];
+					found |= (mask[k] != 0);
+				}
 			}
-			if ((*node)->coexistingNodesFromOtherMdds.empty())
-			{
-				// delete the node, and continue up the levels if necessary
-				SyncMDDNode* p = *node;
-				node++;
-				copy.deleteNode(p, i);
-			}
-			else
-				node++;
 		}
-		if (copy.levels[i].empty())
-		{
-			copy.clear();
+		if (!found)
 			return false;
-		}
+		coexisting.swap(next_coexisting);
 	}
-	copy.clear();
 	return true;
 }
@@ -95,7 +95,7 @@ bool operator < (const Conflict& conflict1, const Conflict& conflict2) // return
 		{
 			if (conflict1.secondary_priority == conflict2.secondary_priority)
 			{
-				return rand() % 2;
+				return threadRand() % 2;
 			}
 			return conflict1.secondary_priority > conflict2.secondary_priority;
 		}
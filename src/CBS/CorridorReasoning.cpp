@@ -1,15 +1,18 @@
 #include "CorridorReasoning.h"
 #include "Conflict.h"
 #include <memory>
+#include <boost/functional/hash.hpp>
 #include "SpaceTimeAStar.h"
+#include "Profiler.h"
 #include "SIPP.h"
 
 shared_ptr<Conflict> CorridorReasoning::run(const shared_ptr<Conflict>& conflict,
 	const vector<Path*>& paths, const HLNode& node)
 {
-	clock_t t = clock();
+	PROFILE_SCOPE("corridor reasoning");
+	auto t = Time::now();
 	auto corridor = findCorridorConflict(conflict, paths, node);
-	accumulated_runtime += (double)(clock() - t) / CLOCKS_PER_SEC;
+	accumulated_runtime += ((fsec)(Time::now() - t)).count();
 	return corridor;
 }
 
@@ -42,45 +45,23 @@ int CorridorReasoning::findCorridor(const shared_ptr<Conflict>& conflict,
 	endpoints[1] = paths[conflict->a2]->at(endpoints_time[1]).location; // the exit location for agent 2
 	if (endpoints[0] == endpoints[1]) // agents exit the corridor in the same direction
 		return 0;
-	// count the distance between the two endpoints, and
-	// check whether the corridor between the two exit locations traverse the conflict location, 
-	// which indicates whether the two agents come in different directions
-	int prev = endpoints[0];
-	int curr = paths[conflict->a1]->at(endpoints_time[0] - 1).location;
-	bool traverseTheConflictingLocation = false;
-	int corridor_length = 1;
-	while (curr != endpoints[1])
-	{
-		if (curr == loc2)
-			traverseTheConflictingLocation = true;
-		auto neighbors = search_engines[0]->instance.getNeighbors(curr);
-		if (neighbors.size() == 2) // inside the corridor
-		{
-			if (neighbors.front() == prev)
-			{
-				prev = curr;
-				curr = neighbors.back();
-			}
-			else
-			{
-				assert(neighbors.back() == prev);
-				prev = curr;
-				curr = neighbors.front();
-			}
-		}
-		else // exit the corridor without hitting endpoint2
-		{ // indicating that the two agents mvoe in the same direction
-			return 0;
-		}
-		corridor_length++;
-	}
-
-	if (!traverseTheConflictingLocation)
+	// the two exit locations have to be the two ends of the corridor, and
+	// the corridor has to contain the conflicting location,
+	// which indicates that the two agents come in different directions
+	const auto& instance = search_engines[0]->instance;
+	int corridor_id = instance.getCorridorId(loc2);
+	if (corridor_id < 0)
 		return 0;
+	const auto& corridor = instance.getCorridor(corridor_id);
+	if (!(corridor.ends[0] == endpoints[0] && corridor.ends[1] == endpoints[1]) &&
+		!(corridor.ends[0] == endpoints[1] && corridor.ends[1] == endpoints[0]))
+		return 0;
+	int corridor_length = corridor.length;
+
 	// When k=2, it might just be a corner cell, which we do not want to recognize as a corridor
 	if (corridor_length == 2 &&
-		search_engines[0]->instance.getColCoordinate(endpoints[0]) != search_engines[0]->instance.getColCoordinate(endpoints[1]) &&
-		search_engines[0]->instance.getRowCoordinate(endpoints[0]) != search_engines[0]->instance.getRowCoordinate(endpoints[1]))
+		instance.getColCoordinate(endpoints[0]) != instance.getColCoordinate(endpoints[1]) &&
+		instance.getRowCoordinate(endpoints[0]) != instance.getRowCoordinate(endpoints[1]))
 	{
 		return 0;
 	}
@@ -134,18 +115,16 @@ shared_ptr<Conflict> CorridorReasoning::findCorridorConflict(const shared_ptr<Co
 	pair<int, int> edge; // one edge in the corridor
 	int corridor_length = getCorridorLength(*paths[a[0]], t[0], u[1], edge);
 	int t3, t3_, t4, t4_;
-	ConstraintTable ct1(initial_constraints[conflict->a1]);
-    ct1.insert2CT(node, conflict->a1);
-	t3 = search_engines[conflict->a1]->getTravelTime(paths[conflict->a1]->front().location, u[1], ct1, MAX_TIMESTEP);
-	ct1.insert2CT(edge.first, edge.second, 0, MAX_TIMESTEP); // block the corridor in both directions
-	ct1.insert2CT(edge.second, edge.first, 0, MAX_TIMESTEP);
-	t3_ = search_engines[conflict->a1]->getTravelTime(paths[conflict->a1]->front().location, u[1], ct1, t3 + 2 * corridor_length + 1);
-	ConstraintTable ct2(initial_constraints[conflict->a2]);
-    ct2.insert2CT(node, conflict->a2);
-	t4 = search_engines[conflict->a2]->getTravelTime(paths[conflict->a2]->front().location, u[0], ct2, MAX_TIMESTEP);
-	ct2.insert2CT(edge.first, edge.second, 0, MAX_TIMESTEP); // block the corridor in both directions
-	ct2.insert2CT(edge.second, edge.first, 0, MAX_TIMESTEP);
-	t4_ = search_engines[conflict->a2]->getTravelTime(paths[conflict->a2]->front().location, u[0], ct2, t3 + corridor_length + 1);
+	TravelTimeQuery query1 { conflict->a1, paths[conflict->a1]->front().location, u[1], make_pair(-1, -1) };
+	getConstraints(node, conflict->a1, query1.constraints);
+	t3 = getTravelTime(query1, node, MAX_TIMESTEP);
+	query1.blocked_edge = edge; // block the corridor in both directions
+	t3_ = getTravelTime(query1, node, t3 + 2 * corridor_length + 1);
+	TravelTimeQuery query2 { conflict->a2, paths[conflict->a2]->front().location, u[0], make_pair(-1, -1) };
+	getConstraints(node, conflict->a2, query2.constraints);
+	t4 = getTravelTime(query2, node, MAX_TIMESTEP);
+	query2.blocked_edge = edge; // block the corridor in both directions
+	t4_ = getTravelTime(query2, node, t3 + corridor_length + 1);
 
     if (abs(t3 - t4) <= corridor_length && t3_ > t3 && t4_ > t4)
     {
@@ -161,6 +140,67 @@ shared_ptr<Conflict> CorridorReasoning::findCorridorConflict(const shared_ptr<Co
 }
 
 
+// collect the constraints that ConstraintTable::insert2CT(node, agent) takes into account
+void CorridorReasoning::getConstraints(const HLNode& node, int agent, vector<Constraint>& constraints) const
+{
+	constraints.clear();
+	for (auto curr = &node; curr->parent != nullptr; curr = curr->parent)
+	{
+		const auto& front = curr->constraints.front();
+		if (get<4>(front) == constraint_type::LEQLENGTH ||
+			get<4>(front) == constraint_type::POSITIVE_VERTEX ||
+			get<4>(front) == constraint_type::POSITIVE_EDGE ||
+			get<0>(front) == agent)
+			constraints.insert(constraints.end(), curr->constraints.begin(), curr->constraints.end());
+	}
+	std::sort(constraints.begin(), constraints.end());
+}
+
+// return the length of the shortest path for query, or MAX_TIMESTEP if it is not shorter than upper_bound
+int CorridorReasoning::getTravelTime(TravelTimeQuery& query, const HLNode& node, int upper_bound)
+{
+	auto got = travel_times.find(query);
+	if (got != travel_times.end())
+	{
+		if (got->second.length < MAX_TIMESTEP) // the shortest path is known
+			return got->second.length < upper_bound ? got->second.length : MAX_TIMESTEP;
+		if (got->second.upper_bound >= upper_bound) // no path is shorter than a larger upper bound
+			return MAX_TIMESTEP;
+	}
+	ConstraintTable constraint_table(initial_constraints[query.agent]);
+	constraint_table.insert2CT(node, query.agent);
+	if (query.blocked_edge.first >= 0)
+	{
+		constraint_table.insert2CT(query.blocked_edge.first, query.blocked_edge.second, 0, MAX_TIMESTEP);
+		constraint_table.insert2CT(query.blocked_edge.second, query.blocked_edge.first, 0, MAX_TIMESTEP);
+	}
+	int length = search_engines[query.agent]->getTravelTime(query.start, query.end, constraint_table, upper_bound);
+	if (got != travel_times.end())
+		got->second = { length, upper_bound };
+	else
+		travel_times.emplace(query, TravelTime{ length, upper_bound });
+	return length;
+}
+
+std::size_t CorridorReasoning::TravelTimeQuery::Hasher::operator()(const TravelTimeQuery& query) const
+{
+	size_t seed = 0;
+	boost::hash_combine(seed, query.agent);
+	boost::hash_combine(seed, query.start);
+	boost::hash_combine(seed, query.end);
+	boost::hash_combine(seed, query.blocked_edge.first);
+	boost::hash_combine(seed, query.blocked_edge.second);
+	for (const auto& constraint : query.constraints)
+	{
+		boost::hash_combine(seed, get<0>(constraint));
+		boost::hash_combine(seed, get<1>(constraint));
+		boost::hash_combine(seed, get<2>(constraint));
+		boost::hash_combine(seed, get<3>(constraint));
+		boost::hash_combine(seed, (int)get<4>(constraint));
+	}
+	return seed;
+}
+
 int CorridorReasoning::getExitingTime(const std::vector<PathEntry>& path, int t)
 {
 	if (t >= (int)path.size())
@@ -1,4 +1,5 @@
 #include "ECBS.h"
+#include "Profiler.h"
 
 
 bool ECBS::solve(double time_limit, int _cost_lowerbound)
@@ -14,13 +15,14 @@ bool ECBS::solve(double time_limit, int _cost_lowerbound)
 		cout << name << ": ";
 	}
 	// set timer
-	start = clock();
+	start = Time::now();
 
     if(!generateRoot())
         return false;
 
 	while (!cleanup_list.empty() && !solution_found)
 	{
+		PROFILE_SCOPE("CT node");
 		auto curr = selectNode();
 		if (terminate(curr))
         {
@@ -32,9 +34,9 @@ bool ECBS::solve(double time_limit, int _cost_lowerbound)
 		if ((curr == dummy_start || curr->chosen_from == "cleanup") &&
 		     !curr->h_computed) // heuristics has not been computed yet
 		{
-            runtime = (double)(clock() - start) / CLOCKS_PER_SEC;
+            runtime = ((fsec)(Time::now() - start)).count();
             bool succ = heuristic_helper.computeInformedHeuristics(*curr, min_f_vals, time_limit - runtime);
-            runtime = (double)(clock() - start) / CLOCKS_PER_SEC;
+            runtime = ((fsec)(Time::now() - start)).count();
             if (!succ) // no solution, so prune this node
             {
                 if (screen > 1)
@@ -64,7 +66,7 @@ bool ECBS::solve(double time_limit, int _cost_lowerbound)
                     return solution_found;
                 }
 				foundBypass = false;
-				ECBSNode* child[2] = { new ECBSNode() , new ECBSNode() };
+				ECBSNode* child[2] = { node_pool.create(), node_pool.create() };
 				curr->conflict = chooseConflict(*curr);
 				addConstraints(curr, child[0], child[1]);
 				if (screen > 1)
@@ -83,7 +85,7 @@ bool ECBS::solve(double time_limit, int _cost_lowerbound)
 					solved[i] = generateChild(child[i], curr);
 					if (!solved[i])
 					{
-						delete (child[i]);
+						node_pool.recycle(child[i]);
 						continue;
 					}
 					else if (i == 1 && !solved[0])
@@ -95,7 +97,7 @@ bool ECBS::solve(double time_limit, int _cost_lowerbound)
 						foundBypass = true;
 						for (const auto& path : child[i]->paths)
 						{
-						    if ((double)path.second.first.size() - 1 > suboptimality * fmin_copy[path.first]) // Our bypassing
+						    if ((double)path.path->size() - 1 > suboptimality * fmin_copy[path.agent]) // Our bypassing
 							{
 								foundBypass = false;
 								break;
@@ -103,7 +105,7 @@ bool ECBS::solve(double time_limit, int _cost_lowerbound)
 						}
 						if (foundBypass)
 						{
-							adoptBypass(curr, child[i], fmin_copy);
+							adoptBypass(curr, child[i]);
 							if (screen > 1)
 								cout << "	Update " << *curr << endl;
 							break;
@@ -114,12 +116,14 @@ bool ECBS::solve(double time_limit, int _cost_lowerbound)
 				{
 					for (auto & i : child)
 					{
-						delete i;
+						node_pool.recycle(i);
 					}
                     classifyConflicts(*curr); // classify the new-detected conflicts
 				}
 				else
 				{
+					paths = path_copy; // paths belong to curr again
+					min_f_vals = fmin_copy;
 					for (int i = 0; i < 2; i++)
 					{
 						if (solved[i])
@@ -137,7 +141,7 @@ bool ECBS::solve(double time_limit, int _cost_lowerbound)
 		}
 		else // no bypass
 		{
-			ECBSNode* child[2] = { new ECBSNode() , new ECBSNode() };
+			ECBSNode* child[2] = { node_pool.create(), node_pool.create() };
 			curr->conflict = chooseConflict(*curr);
 			addConstraints(curr, child[0], child[1]);
 
@@ -157,7 +161,7 @@ bool ECBS::solve(double time_limit, int _cost_lowerbound)
 				solved[i] = generateChild(child[i], curr);
 				if (!solved[i])
 				{
-					delete (child[i]);
+					node_pool.recycle(child[i]);
 					continue;
 				}
 				pushNode(child[i]);
@@ -165,6 +169,8 @@ bool ECBS::solve(double time_limit, int _cost_lowerbound)
 				if (screen > 1)
 					cout << "		Generate " << *child[i] << endl;
 			}
+			paths = path_copy; // paths belong to curr again
+			min_f_vals = fmin_copy;
 		}
 		switch (curr->conflict->type)
 		{
@@ -202,7 +208,7 @@ bool ECBS::solve(double time_limit, int _cost_lowerbound)
 	return solution_found;
 }
 
-void ECBS::adoptBypass(ECBSNode* curr, ECBSNode* child, const vector<int>& fmin_copy)
+void ECBS::adoptBypass(ECBSNode* curr, ECBSNode* child)
 {
 	num_adopt_bypass++;
 	curr->sum_of_costs = child->sum_of_costs;
@@ -212,61 +218,20 @@ void ECBS::adoptBypass(ECBSNode* curr, ECBSNode* child, const vector<int>& fmin_
 	curr->unknownConf = child->unknownConf;
 	curr->conflict = nullptr;
 	curr->makespan = child->makespan;
-	for (const auto& path : child->paths) // update paths
-	{
-		auto p = curr->paths.begin();
-		while (p != curr->paths.end())
-		{
-			if (path.first == p->first)
-			{
-				p->second.first = path.second.first;
-				paths[p->first] = &p->second.first;
-                min_f_vals[p->first] = p->second.second;
-				break;
-			}
-			++p;
-		}
-		if (p == curr->paths.end())
-		{
-			curr->paths.emplace_back(path);
-			curr->paths.back().second.second = fmin_copy[path.first];
-			paths[path.first] = &curr->paths.back().second.first;
-			min_f_vals[path.first] = fmin_copy[path.first];
-		}
-	}
+	adoptPaths(curr, child, paths, &min_f_vals);
 }
 
-// takes the paths_found_initially and UPDATE all (constrained) paths found for agents from curr to start
-// also, do the same for ll_min_f_vals and paths_costs (since its already "on the way").
+// moves paths and min_f_vals from paths_node to curr, touching only the agents replanned between the two CT nodes
 void ECBS::updatePaths(ECBSNode* curr)
 {
-	for (int i = 0; i < num_of_agents; i++)
-	{
-		paths[i] = &paths_found_initially[i].first;
-		min_f_vals[i] = paths_found_initially[i].second;
-	}
-	vector<bool> updated(num_of_agents, false);  // initialized for false
-
-	while (curr != nullptr)
-	{
-		for (auto & path : curr->paths)
-		{
-			int agent = path.first;
-			if (!updated[agent])
-			{
-				paths[agent] = &path.second.first;
-				min_f_vals[agent] = path.second.second;
-				updated[agent] = true;
-			}
-		}
-		curr = curr->parent;
-	}
+	switchPaths((const ECBSNode*)paths_node, (const ECBSNode*)curr, paths, &min_f_vals);
+	paths_node = curr;
 }
 
 
 bool ECBS::generateRoot()
 {
-	auto root = new ECBSNode();
+	auto root = node_pool.create();
 	root->g_val = 0;
 	root->sum_of_costs = 0;
 	paths.resize(num_of_agents, nullptr);
@@ -286,14 +251,14 @@ bool ECBS::generateRoot()
 		if (paths_found_initially[i].first.empty())
 		{
 			cerr << "No path exists for agent " << i << endl;
-			delete root;
+			node_pool.recycle(root);
 			return false;
 		}
-        runtime = (double)(clock() - start) / CLOCKS_PER_SEC;
-		if (runtime > time_limit)
+        runtime = ((fsec)(Time::now() - start)).count();
+		if (runtime > time_limit || isInterrupted())
         {
 		    cout << "Time out when generating the root CT node" << endl;
-            delete root;
+            node_pool.recycle(root);
 		    return false;
         }
 		paths[i] = &paths_found_initially[i].first;
@@ -305,6 +270,7 @@ bool ECBS::generateRoot()
 
 	root->h_val = 0;
 	root->depth = 0;
+	paths_node = root;
 	findConflicts(*root);
     heuristic_helper.computeQuickHeuristics(*root);
 	pushNode(root);
@@ -319,7 +285,7 @@ bool ECBS::generateRoot()
 
 bool ECBS::generateChild(ECBSNode*  node, ECBSNode* parent)
 {
-	clock_t t1 = clock();
+	auto t1 = Time::now();
 	node->parent = parent;
 	node->HLNode::parent = parent;
 	node->g_val = parent->g_val;
@@ -334,34 +300,34 @@ bool ECBS::generateChild(ECBSNode*  node, ECBSNode* parent)
 		{
             if (screen > 1)
                 cout << "	No paths for agent " << agent << ". Node pruned." << endl;
-			runtime_generate_child += (double)(clock() - t1) / CLOCKS_PER_SEC;
+			runtime_generate_child += ((fsec)(Time::now() - t1)).count();
 			return false;
 		}
 	}
 
 	findConflicts(*node);
 	heuristic_helper.computeQuickHeuristics(*node);
-	runtime_generate_child += (double)(clock() - t1) / CLOCKS_PER_SEC;
+	runtime_generate_child += ((fsec)(Time::now() - t1)).count();
 	return true;
 }
 
 
 bool ECBS::findPathForSingleAgent(ECBSNode*  node, int ag)
 {
-	clock_t t = clock();
+	auto t = Time::now();
 	auto new_path = search_engines[ag]->findSuboptimalPath(*node, initial_constraints[ag], paths, ag, min_f_vals[ag], suboptimality);
 	runtime_build_CT += search_engines[ag]->runtime_build_CT;
 	runtime_build_CAT += search_engines[ag]->runtime_build_CAT;
-	runtime_path_finding += (double)(clock() - t) / CLOCKS_PER_SEC;
+	runtime_path_finding += ((fsec)(Time::now() - t)).count();
 	if (new_path.first.empty())
 		return false;
 	assert(!isSamePath(*paths[ag], new_path.first));
-	node->paths.emplace_back(ag, new_path);
 	node->g_val = node->g_val - min_f_vals[ag] + new_path.second;
 	node->sum_of_costs = node->sum_of_costs - (int) paths[ag]->size() + (int) new_path.first.size();
-	paths[ag] = &node->paths.back().second.first;
-	min_f_vals[ag] = new_path.second;
 	node->makespan = max(node->makespan, new_path.first.size() - 1);
+	node->paths.emplace_back(ag, std::move(new_path.first), paths[ag], new_path.second, min_f_vals[ag]);
+	paths[ag] = node->paths.back().path.get();
+	min_f_vals[ag] = new_path.second;
 	return true;
 }
 
@@ -383,7 +349,7 @@ inline void ECBS::pushNode(ECBSNode* node)
 			node->focal_handle = focal_list.push(node);
 		break;
 	case high_level_solver_type::EES:
-		node->open_handle = open_list.push(node);
+		node->open_handle = open_list.insert(node);
 		if (node->getFHatVal() <= suboptimality * inadmissible_cost_lowerbound)
 			node->focal_handle = focal_list.push(node);
 		break;
@@ -411,7 +377,7 @@ inline bool ECBS::reinsertNode(ECBSNode* node)
 		break;
 	case high_level_solver_type::EES:
         node->cleanup_handle = cleanup_list.push(node);
-		node->open_handle = open_list.push(node);
+		node->open_handle = open_list.insert(node);
 		if (node->getFHatVal() <= suboptimality * inadmissible_cost_lowerbound)
 			node->focal_handle = focal_list.push(node);
 		break;
@@ -434,15 +400,23 @@ ECBSNode* ECBS::selectNode()
 	{
 	case high_level_solver_type::EES:
 		// update the focal list if necessary
-		if (open_list.top()->getFHatVal() != inadmissible_cost_lowerbound)
+		if ((*open_list.begin())->getFHatVal() != inadmissible_cost_lowerbound)
 		{
-			inadmissible_cost_lowerbound = open_list.top()->getFHatVal();
-			double focal_list_threshold = suboptimality * inadmissible_cost_lowerbound;
-			focal_list.clear();
-			for (auto n : open_list)
+			// only the nodes whose f^-vals are between the old and the new thresholds enter or leave FOCAL
+			double old_focal_list_threshold = suboptimality * inadmissible_cost_lowerbound;
+			inadmissible_cost_lowerbound = (*open_list.begin())->getFHatVal();
+			double new_focal_list_threshold = suboptimality * inadmissible_cost_lowerbound;
+			if (new_focal_list_threshold > old_focal_list_threshold)
 			{
-				if (n->getFHatVal() <= focal_list_threshold)
-					n->focal_handle = focal_list.push(n);
+				for (auto it = open_list.upper_bound(old_focal_list_threshold);
+					 it != open_list.end() && (*it)->getFHatVal() <= new_focal_list_threshold; ++it)
+					(*it)->focal_handle = focal_list.push(*it);
+			}
+			else
+			{
+				for (auto it = open_list.upper_bound(new_focal_list_threshold);
+					 it != open_list.end() && (*it)->getFHatVal() <= old_focal_list_threshold; ++it)
+					focal_list.erase((*it)->focal_handle);
 			}
 		}
 
@@ -458,11 +432,11 @@ ECBSNode* ECBS::selectNode()
 			cleanup_list.erase(curr->cleanup_handle);
 			open_list.erase(curr->open_handle);
 		}
-		else if (open_list.top()->sum_of_costs <= suboptimality * cost_lowerbound)
+		else if ((*open_list.begin())->sum_of_costs <= suboptimality * cost_lowerbound)
 		{ // return best f_hat
-			curr = open_list.top();
+			curr = *open_list.begin();
 			curr->chosen_from = "open";
-			open_list.pop();
+			open_list.erase(open_list.begin());
 			cleanup_list.erase(curr->cleanup_handle);
 			focal_list.erase(curr->focal_handle);
 		}
@@ -571,6 +545,29 @@ void ECBS::classifyConflicts(ECBSNode &node)
 {
     if (node.unknownConf.empty())
         return;
+	if (node.parent == nullptr)
+	{ // the root has many conflicts, so build the MDDs that classifying them needs in parallel first
+		vector<pair<int, size_t>> agents;
+		vector<bool> added(num_of_agents, false);
+		for (const auto& con : node.unknownConf)
+		{
+			int a1 = con->a1, a2 = con->a2;
+			int timestep = get<3>(con->constraint1.back());
+			bool shortest1 = (int)paths[a1]->size() - 1 == min_f_vals[a1];
+			bool shortest2 = (int)paths[a2]->size() - 1 == min_f_vals[a2];
+			if (!PC || (node.chosen_from != "cleanup" && !shortest1 && !shortest2))
+				continue;
+			for (int a : {a1, a2})
+			{
+				if (!added[a] && timestep < (int)paths[a]->size())
+				{
+					added[a] = true;
+					agents.emplace_back(a, paths[a]->size());
+				}
+			}
+		}
+		buildMDDsInParallel(node, agents);
+	}
 	// Classify all conflicts in unknownConf
 	while (!node.unknownConf.empty())
 	{
@@ -708,9 +705,8 @@ void ECBS::releaseNodes()
     open_list.clear();
     cleanup_list.clear();
     focal_list.clear();
-    for (auto& node : allNodes_table)
-        delete node;
     allNodes_table.clear();
+    node_pool.release();
 }
 
 void ECBS::clear()
@@ -720,6 +716,7 @@ void ECBS::clear()
     releaseNodes();
     paths.clear();
     paths_found_initially.clear();
+    paths_node = nullptr;
     min_f_vals.clear();
     dummy_start = nullptr;
     goal_node = nullptr;
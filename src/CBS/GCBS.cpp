@@ -3,24 +3,14 @@
 #include <random>      // std::default_random_engine
 #include <chrono>       // std::chrono::system_clock
 #include "SpaceTimeAStar.h"
+#include "Profiler.h"
 
 
-// takes the paths_found_initially and UPDATE all (constrained) paths found for agents from curr to start
+// moves paths from paths_node to curr, touching only the agents replanned between the two CT nodes
 void GCBS::updatePaths(GCBSNode* curr)
 {
-    vector<bool> updated(num_of_agents, false);  // initialized for false
-    while (curr != nullptr)
-    {
-        for (auto & path : curr->paths)
-        {
-            if (!updated[path.first])
-            {
-                paths[path.first] = &(path.second);
-                updated[path.first] = true;
-            }
-        }
-        curr = curr->parent;
-    }
+    switchPaths(paths_node, (const GCBSNode*)curr, paths);
+    paths_node = curr;
 }
 
 void GCBS::copyConflicts(const list<shared_ptr<Conflict >>& conflicts,
@@ -60,7 +50,7 @@ void GCBS::findConflicts(GCBSNode& curr, int a1, int a2)
             int loc2 = paths[a2_]->at(timestep).location;
             if (loc1 == loc2)
             {
-                shared_ptr<Conflict> conflict(new Conflict());
+                auto conflict = make_shared<Conflict>();
                 if (target_reasoning)
                     conflict->targetConflict(a1_, a2_, loc1, timestep);
                 else
@@ -78,7 +68,7 @@ void GCBS::findConflicts(GCBSNode& curr, int a1, int a2)
         int loc2 = paths[a2]->at(timestep).location;
         if (loc1 == loc2)
         {
-            shared_ptr<Conflict> conflict(new Conflict());
+            auto conflict = make_shared<Conflict>();
             if (target_reasoning && paths[a1]->size() == timestep + 1)
             {
                 conflict->targetConflict(a1, a2, loc1, timestep);
@@ -100,7 +90,7 @@ void GCBS::findConflicts(GCBSNode& curr, int a1, int a2)
                  && loc1 == paths[a2]->at(timestep + 1).location
                  && loc2 == paths[a1]->at(timestep + 1).location)
         {
-            shared_ptr<Conflict> conflict(new Conflict());
+            auto conflict = make_shared<Conflict>();
             conflict->edgeConflict(a1, a2, loc1, loc2, timestep + 1);
             assert(!conflict->constraint1.empty());
             assert(!conflict->constraint2.empty());
@@ -114,7 +104,7 @@ void GCBS::findConflicts(GCBSNode& curr, int a1, int a2)
 
 void GCBS::findConflicts(GCBSNode& curr)
 {
-    clock_t t = clock();
+    auto t = Time::now();
     if (curr.parent != nullptr)
     {
         // Copy from parent
@@ -154,7 +144,7 @@ void GCBS::findConflicts(GCBSNode& curr)
         }
     }
     curr.colliding_pairs = curr.conflicts.size();
-    runtime_detect_conflicts += (double)(clock() - t) / CLOCKS_PER_SEC;
+    runtime_detect_conflicts += ((fsec)(Time::now() - t)).count();
 }
 
 
@@ -177,7 +167,7 @@ shared_ptr<Conflict> GCBS::chooseConflict(const GCBSNode &node) const
 bool GCBS::findPathForSingleAgent(GCBSNode* node, int agent)
 {
     // build constraint table
-    auto t = clock();
+    auto t = Time::now();
     ConstraintTable constraint_table(search_engines[agent]->instance.num_of_cols,
                     search_engines[agent]->instance.map_size, &path_tables->at(agent));
     auto curr = node;
@@ -186,19 +176,19 @@ bool GCBS::findPathForSingleAgent(GCBSNode* node, int agent)
         constraint_table.insert2CT(curr->constraints, agent);
         curr = curr->parent;
     }
-    runtime_build_CT = (double)(clock() - t) / CLOCKS_PER_SEC;
+    runtime_build_CT = ((fsec)(Time::now() - t)).count();
 
     // build CAT
-    t = clock();
+    t = Time::now();
     constraint_table.insert2CAT(agent, paths);
-    runtime_build_CAT = (double)(clock() - t) / CLOCKS_PER_SEC;
+    runtime_build_CAT = ((fsec)(Time::now() - t)).count();
 
     // find a path
-    t = clock();
+    t = Time::now();
     Path new_path = search_engines[agent]->findPath(constraint_table);
-    runtime_path_finding += (double)(clock() - t) / CLOCKS_PER_SEC;
+    runtime_path_finding += ((fsec)(Time::now() - t)).count();
     if (screen > 1)
-        cout << "\t\t\tRuntime of single-agent search = " << (double)(clock() - t) / CLOCKS_PER_SEC <<
+        cout << "\t\t\tRuntime of single-agent search = " << ((fsec)(Time::now() - t)).count() <<
             "s with " << search_engines[agent]->getNumExpanded() << " expanded nodes" << endl;
     if (new_path.empty())
     {
@@ -207,19 +197,19 @@ bool GCBS::findPathForSingleAgent(GCBSNode* node, int agent)
         return false;
     }
     assert(paths[agent] == nullptr or !isSamePath(*paths[agent], new_path));
-    node->paths.emplace_back(agent, new_path);
     if (paths[agent] == nullptr)
         node->sum_of_costs += (int)new_path.size() - 1;
     else
         node->sum_of_costs += - (int)paths[agent]->size() + (int)new_path.size();
-    paths[agent] = &node->paths.back().second;
     node->makespan = max(node->makespan, new_path.size() - 1);
+    node->paths.emplace_back(agent, std::move(new_path), paths[agent]);
+    paths[agent] = node->paths.back().path.get();
     return true;
 }
 
 bool GCBS::generateChild(GCBSNode*  node, GCBSNode* parent)
 {
-    clock_t t1 = clock();
+    auto t1 = Time::now();
     node->parent = parent;
     node->sum_of_costs = parent->sum_of_costs;
     node->makespan = parent->makespan;
@@ -231,13 +221,13 @@ bool GCBS::generateChild(GCBSNode*  node, GCBSNode* parent)
     {
         if (!findPathForSingleAgent(node, agent))
         {
-            runtime_generate_child += (double)(clock() - t1) / CLOCKS_PER_SEC;
+            runtime_generate_child += ((fsec)(Time::now() - t1)).count();
             return false;
         }
     }
 
     findConflicts(*node);
-    runtime_generate_child += (double)(clock() - t1) / CLOCKS_PER_SEC;
+    runtime_generate_child += ((fsec)(Time::now() - t1)).count();
     return true;
 }
 
@@ -270,6 +260,7 @@ GCBSNode* GCBS::selectNode()
 {
     GCBSNode* curr = focal_list.top();
     focal_list.pop();
+    updatePaths(curr);
     return curr;
 }
 
@@ -435,7 +426,7 @@ string GCBS::getSolverName() const
 bool GCBS::solve(double _time_limit)
 {
     // set timer
-    start = clock();
+    start = Time::now();
     this->time_limit = _time_limit;
 
     if (screen > 0) // 1 or 2
@@ -454,13 +445,14 @@ bool GCBS::solve(double _time_limit)
 
     while (!terminate())
     {
+        PROFILE_SCOPE("CT node");
         auto curr = selectNode();
 
         //Expand the node
         num_HL_expanded++;
         curr->time_expanded = num_HL_expanded;
         bool foundBypass = false;
-        GCBSNode* child[2] = { new GCBSNode() , new GCBSNode() };
+        GCBSNode* child[2] = { node_pool.create(), node_pool.create() };
         curr->conflict = chooseConflict(*curr);
         addConstraints(curr, child[0], child[1]);
 
@@ -479,7 +471,7 @@ bool GCBS::solve(double _time_limit)
             solved[i] = generateChild(child[i], curr);
             if (!solved[i])
             {
-                delete (child[i]);
+                node_pool.recycle(child[i]);
                 continue;
             }
             else if (bypass && child[i]->colliding_pairs < curr->colliding_pairs) // Bypass1
@@ -493,25 +485,7 @@ bool GCBS::solve(double _time_limit)
                 curr->conflict = nullptr;
                 curr->sum_of_costs = child[i]->sum_of_costs;
                 curr->makespan = child[i]->makespan;
-                for (const auto& path : child[i]->paths) // update paths
-                {
-                    auto p = curr->paths.begin();
-                    while (p != curr->paths.end())
-                    {
-                        if (path.first == p->first)
-                        {
-                            p->second = path.second;
-                            paths[p->first] = &p->second;
-                            break;
-                        }
-                        ++p;
-                    }
-                    if (p == curr->paths.end())
-                    {
-                        curr->paths.emplace_back(path);
-                        paths[path.first] = &curr->paths.back().second;
-                    }
-                }
+                adoptPaths(curr, child[i], paths);
                 if (screen > 1)
                 {
                     cout << "	Update " << "Node " << curr->time_generated << " ( f = "<< curr->sum_of_costs <<
@@ -525,11 +499,12 @@ bool GCBS::solve(double _time_limit)
         {
             for (auto & i : child)
             {
-                delete i;
+                node_pool.recycle(i);
             }
         }
         else
         {
+            paths = copy; // paths belong to curr again
             for (int i = 0; i < 2; i++)
             {
                 if (solved[i])
@@ -569,7 +544,7 @@ void GCBS::addConstraints(const GCBSNode* curr, GCBSNode* child1, GCBSNode* chil
 {
     if (disjoint_splitting && curr->conflict->type == conflict_type::STANDARD)
     {
-        int first = (bool)(rand() % 2);
+        int first = (bool)(random_engine() % 2);
         if (first) // disjoint splitting on the first agent
         {
             child1->constraints = curr->conflict->constraint1;
@@ -626,16 +601,14 @@ vector<int> GCBS::shuffleAgents() const
 
     if (randomRoot)
     {
-        std::random_device rd;
-        std::mt19937 g(rd());
-        std::shuffle(std::begin(agents), std::end(agents), g);
+        std::shuffle(std::begin(agents), std::end(agents), random_engine);
     }
     return agents;
 }
 
 bool GCBS::generateRoot()
 {
-    auto root = new GCBSNode();
+    auto root = node_pool.create();
     paths.resize(num_of_agents, nullptr);
     for (int i = 0; i < num_of_agents; i++)
     {
@@ -643,6 +616,7 @@ bool GCBS::generateRoot()
         assert(succ);
     }
     root->depth = 0;
+    paths_node = root;
     findConflicts(*root);
 
     pushNode(root);
@@ -656,9 +630,8 @@ bool GCBS::generateRoot()
 inline void GCBS::releaseNodes()
 {
     focal_list.clear();
-    for (auto& node : allNodes_table)
-        delete node;
     allNodes_table.clear();
+    node_pool.release();
 }
 
 GCBS::~GCBS()
@@ -744,11 +717,12 @@ void GCBS::clear()
 {
     releaseNodes();
     paths.clear();
+    paths_node = nullptr;
 }
 
 bool GCBS::terminate()
 {
-    runtime = (double)(clock() - start) / CLOCKS_PER_SEC;
+    runtime = ((fsec)(Time::now() - start)).count();
     if (focal_list.empty() || focal_list.top()->colliding_pairs == 0 || runtime > time_limit)
     {
         if (screen > 0) // 1 or 2
@@ -1,6 +1,9 @@
 #include "MDD.h"
 #include <iostream>
+#include <atomic>
+#include <thread>
 #include "common.h"
+#include "Profiler.h"
 
 bool MDD::buildMDD(ConstraintTable& constraint_table, const SingleAgentSolver* _solver)
 {
@@ -409,81 +412,6 @@ std::ostream& operator<<(std::ostream& os, const MDD& mdd)
 
 
 
-SyncMDD::SyncMDD(const MDD & cpy) // deep copy of a MDD
-{
-	levels.resize(cpy.levels.size());
-	auto root = new SyncMDDNode(cpy.levels[0].front()->location, nullptr);
-	levels[0].push_back(root);
-	for (int t = 0; t < (int)levels.size() - 1; t++)
-	{
-		for (auto node = levels[t].begin(); node != levels[t].end(); ++node)
-		{
-			MDDNode* cpyNode = cpy.find((*node)->location, t);
-			for (list<MDDNode*>::const_iterator cpyChild = cpyNode->children.begin(); cpyChild != cpyNode->children.end(); ++cpyChild)
-			{
-				SyncMDDNode* child = find((*cpyChild)->location, (*cpyChild)->level);
-				if (child == nullptr)
-				{
-					child = new SyncMDDNode((*cpyChild)->location, (*node));
-					levels[t + 1].push_back(child);
-					(*node)->children.push_back(child);
-				}
-				else
-				{
-					child->parents.push_back(*node);
-					(*node)->children.push_back(child);
-				}
-			}
-		}
-
-	}
-}
-
-SyncMDDNode* SyncMDD::find(int location, int level) const
-{
-	if (level < (int)levels.size())
-		for (auto it : levels[level])
-			if (it->location == location)
-				return it;
-	return nullptr;
-}
-
-void SyncMDD::deleteNode(SyncMDDNode* node, int level)
-{
-	levels[level].remove(node);
-	for (auto child = node->children.begin(); child != node->children.end(); ++child)
-	{
-		(*child)->parents.remove(node);
-		if ((*child)->parents.empty())
-			deleteNode(*child, level + 1);
-	}
-	for (auto parent = node->parents.begin(); parent != node->parents.end(); ++parent)
-	{
-		(*parent)->children.remove(node);
-		if ((*parent)->children.empty())
-			deleteNode(*parent, level - 1);
-	}
-}
-
-
-void SyncMDD::clear()
-{
-	if (levels.empty())
-		return;
-	for (auto & level : levels)
-	{
-		for (auto & it : level)
-			delete it;
-	}
-	levels.clear();
-}
-
-
-SyncMDD::~SyncMDD()
-{
-	clear();
-}
-
 MDD* MDDTable::findMDD(HLNode& node, int agent) const
 {
     ConstraintsHasher c(agent, &node);
@@ -505,7 +433,8 @@ MDD * MDDTable::getMDD(HLNode& node, int id, size_t mdd_levels)
 		return got->second;
 	}
 	releaseMDDMemory(id);
-	clock_t t = clock();
+	PROFILE_SCOPE("MDD");
+	auto t = Time::now();
 	MDD * mdd = new MDD();
 	ConstraintTable ct(initial_constraints[id]);
     ct.insert2CT(node, id);
@@ -517,10 +446,47 @@ MDD * MDDTable::getMDD(HLNode& node, int id, size_t mdd_levels)
 	{
 		lookupTable[c.a][c] = mdd;
 	}
-	accumulated_runtime += (double)(clock() - t) / CLOCKS_PER_SEC;
+	accumulated_runtime += ((fsec)(Time::now() - t)).count();
 	return mdd;
 }
 
+void MDDTable::buildMDDs(HLNode& node, const vector<pair<int, size_t>>& agents, int num_of_threads)
+{
+	vector<MDD*> mdds(agents.size(), nullptr);
+	std::atomic<size_t> next(0);
+	auto build = [&]()
+	{ // each agent has its own search engine, and the table is only modified after all threads are done
+		for (size_t i = next++; i < agents.size(); i = next++)
+		{
+			int id = agents[i].first;
+			mdds[i] = new MDD();
+			ConstraintTable ct(initial_constraints[id]);
+			ct.insert2CT(node, id);
+			if (node.getName() == "CBS Node")
+				mdds[i]->buildMDD(ct, agents[i].second, search_engines[id]);
+			else // ECBS node
+				mdds[i]->buildMDD(ct, search_engines[id]);
+		}
+	};
+	auto start = std::chrono::steady_clock::now();
+	num_of_threads = min(num_of_threads, (int)agents.size());
+	vector<std::thread> threads;
+	for (int i = 1; i < num_of_threads; i++)
+		threads.emplace_back(build);
+	build();
+	for (auto& thread : threads)
+		thread.join();
+	for (size_t i = 0; i < agents.size(); i++)
+	{
+		ConstraintsHasher c(agents[i].first, &node);
+		if (lookupTable.empty() || lookupTable[c.a].count(c) > 0)
+			delete mdds[i];
+		else
+			lookupTable[c.a][c] = mdds[i];
+	}
+	accumulated_runtime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
 void MDDTable::releaseMDDMemory(int id)
 {
 	if (id < 0 || lookupTable.empty() || (int)lookupTable[id].size() < max_num_of_mdds)
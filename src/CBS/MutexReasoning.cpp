@@ -1,12 +1,14 @@
 #include "MutexReasoning.h"
 #include "ConstraintPropagation.h"
+#include "Profiler.h"
 
 
 shared_ptr<Conflict> MutexReasoning::run(int a1, int a2, CBSNode& node, MDD* mdd_1, MDD* mdd_2)
 {
-	clock_t t = clock();
+	PROFILE_SCOPE("mutex reasoning");
+	auto t = Time::now();
 	auto conflict = findMutexConflict(a1, a2, node, mdd_1, mdd_2);
-	accumulated_runtime += (double)(clock() - t) / CLOCKS_PER_SEC;
+	accumulated_runtime += ((fsec)(Time::now() - t)).count();
 	return conflict;
 }
 
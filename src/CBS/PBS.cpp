@@ -1,9 +1,10 @@
 #include "PBS.h"
+#include "Profiler.h"
 
 bool PBS::solve(double _time_limit, int _node_limit, int _collsion_threshold)
 {
     // set timer
-    start = clock();
+    start = Time::now();
     this->time_limit = _time_limit;
     this->node_limit = _node_limit;
     this->collsion_threshold = _collsion_threshold;
@@ -22,6 +23,7 @@ bool PBS::solve(double _time_limit, int _node_limit, int _collsion_threshold)
 
     while (!terminate())
     {
+        PROFILE_SCOPE("CT node");
         // Select the node
         auto curr = open_list.top();
         open_list.pop();
@@ -52,9 +54,6 @@ PBS::PBS(vector<SingleAgentSolver*>& search_engines, PathTableWC & path_table, i
          search_engines(search_engines), path_table(path_table), screen(screen), num_of_agents(search_engines.size()) {}
 PBS::~PBS()
 {
-    for (auto node : all_nodes)
-        delete node;
-    all_nodes.clear();
     open_list.clear();
 }
 
@@ -63,19 +62,20 @@ bool PBS::generateRoot()
     if (screen >= 2)
         cout << "Generate Root node " << endl;
 
-    root_node = new PBSNode();
+    root_node = node_pool.create();
     root_node->priority = make_pair(-1, -1);
+    paths.assign(num_of_agents, nullptr);
+    paths_node = nullptr;
     update(*root_node);
-    set<int> higher_agents, lower_agents;
 
     // Plan paths
     if (initial_paths.empty())
     {
         for (auto i = 0; i < num_of_agents; i++)
         {
-            if(!planPath(i, *root_node, higher_agents, lower_agents))
+            if(!planPath(i, *root_node))
             {
-                delete root_node;
+                node_pool.recycle(root_node);
                 return false;
             }
         }
@@ -87,8 +87,8 @@ bool PBS::generateRoot()
             assert(initial_paths[i] != nullptr and
                     initial_paths[i]->front().location == search_engines[i]->start_location and
                     initial_paths[i]->back().location == search_engines[i]->goal_location);
-            root_node->new_paths.emplace_back(i, *initial_paths[i]);
-            paths[i] = &root_node->new_paths.back().second;
+            root_node->paths.emplace_back(i, Path(*initial_paths[i]), nullptr);
+            paths[i] = root_node->paths.back().path.get();
             root_node->sum_of_costs += (int)initial_paths[i]->size() - 1;
         }
     }
@@ -100,7 +100,7 @@ bool PBS::generateRoot()
         {
             findInternalConflicts(*root_node, i, j);
         }
-        findExternalConflicts(*root_node, i, lower_agents);
+        findExternalConflicts(*root_node, i);
     }
     best_node = root_node;
     pushNode(root_node);
@@ -110,8 +110,9 @@ bool PBS::generateChild(PBSNode& parent, bool left_child)
 {
     if (screen > 1)
         cout << "Generate Node " << num_HL_generated + 1 << " with constraint ";
-    auto child = new PBSNode();
+    auto child = node_pool.create();
     child->parent = &parent;
+    child->depth = parent.depth + 1;
     child->conflicts = parent.conflicts;
     child->abandoned_conflicts = parent.abandoned_conflicts;
     child->sum_of_costs = parent.sum_of_costs;
@@ -156,28 +157,25 @@ bool PBS::generateChild(PBSNode& parent, bool left_child)
 
     update(*child);
 
-    list<int> ordered_agents;
-    topologicalSort(ordered_agents);
-
+    const auto& ordered_agents = priorities.ordered_agents;
     set<int> to_replan;
     to_replan.insert(child->priority.first);
-    for(auto pt = std::find(ordered_agents.begin(), ordered_agents.end(), child->priority.first);
-        !to_replan.empty(); ++pt)
+    for(auto i = priorities.order[child->priority.first]; !to_replan.empty(); i++)
     {
-        int rst = to_replan.erase(*pt);
-        if (rst == 0) // pt is not in to_replan
+        int rst = to_replan.erase(ordered_agents[i]);
+        if (rst == 0) // the agent is not in to_replan
             continue;
 
-        auto a1 = *pt;
-        set<int> higher_agents;
-        getHigherPriorityAgents(a1, higher_agents, ordered_agents);
-        set<int> lower_agents;
-        getLowerPriorityAgents(a1, lower_agents, ordered_agents);
+        auto a1 = ordered_agents[i];
+        const auto& higher_agents = priorities.higher[a1];
+        const auto& lower_agents = priorities.lower[a1];
 
         // Re-plan path
-        if(!planPath(a1, *child, higher_agents, lower_agents))
+        if(!planPath(a1, *child))
         {
-            delete child;
+            switchPaths((const PBSNode*)child, (const PBSNode*)&parent, paths); // undo the new paths of child
+            paths_node = &parent;
+            node_pool.recycle(child);
             return false;
         }
 
@@ -189,80 +187,74 @@ bool PBS::generateChild(PBSNode& parent, bool left_child)
         {
             if (a1 == a2)
                 continue;
-            if (higher_agents.count(a2) > 0) // the path will not collide with the agents with higher priority
+            if (higher_agents[a2]) // the path will not collide with the agents with higher priority
             {
                 assert(!findInternalConflicts(*child, a1, a2));
                 continue;
             }
             if (findInternalConflicts(*child, a1, a2))
             {
-                if (lower_agents.count(a2) > 0) // has a collision with a lower priority agent
+                if (lower_agents[a2]) // has a collision with a lower priority agent
                     to_replan.insert(a2);
             }
         }
-        findExternalConflicts(*child, a1, lower_agents);
+        findExternalConflicts(*child, a1);
     }
 
     pushNode(child);
     return true;
 }
 
-bool PBS::planPath(int agent, PBSNode& node, const set<int> & higher_agents, const set<int> & lower_agents)
+bool PBS::planPath(int agent, PBSNode& node)
 {
+    const auto& higher_agents = priorities.higher[agent];
+    const auto& lower_agents = lower_external_agents[agent];
     if (screen > 1)
         cout << "\t\tReplan path for agent " << agent << " by avoiding collisions with agents ";
     // build constraint table
-    auto t = clock();
+    auto t = Time::now();
     ConstraintTable constraint_table(search_engines[agent]->instance.num_of_cols,
                                      search_engines[agent]->instance.map_size,nullptr, &path_table);
-    for ( auto a : higher_agents)
+    set<int> external_agents(higher_external_agents[agent].begin(), higher_external_agents[agent].end());
+    for (auto a = higher_agents.find_first(); a != AgentSet::npos; a = higher_agents.find_next(a))
     {
-        if (a < 0) // external agent
-        {
-            constraint_table.insert2CT(*path_table.getPath(-a-1));
-            if (screen > 1)
-                cout << "External " <<  - a - 1 << "," << *path_table.getPath(-a-1) << endl;
-        }
-        else // internal agent
-        {
-            assert(paths[a] != nullptr and a != agent);
-            constraint_table.insert2CT(*paths[a]);
-            if (screen > 1)
-                cout << a << "," << *paths[a] << endl;
-        }
-
+        assert(paths[a] != nullptr and (int)a != agent);
+        constraint_table.insert2CT(*paths[a]);
+        if (screen > 1)
+            cout << a << "," << *paths[a] << endl;
+        external_agents.insert(higher_external_agents[a].begin(), higher_external_agents[a].end());
+    }
+    for (auto a : external_agents)
+    {
+        constraint_table.insert2CT(*path_table.getPath(-a-1));
+        if (screen > 1)
+            cout << "External " <<  - a - 1 << "," << *path_table.getPath(-a-1) << endl;
     }
     if (screen > 1)
         cout << endl;
-    runtime_build_CT = (double)(clock() - t) / CLOCKS_PER_SEC;
+    runtime_build_CT = ((fsec)(Time::now() - t)).count();
 
     // build CAT
-    t = clock();
+    t = Time::now();
     for (int a = 0; a < num_of_agents; a++)
     {
-        if (paths[a] != nullptr and a != agent and higher_agents.count(a) == 0)
+        if (paths[a] != nullptr and a != agent and !higher_agents[a])
         {
             constraint_table.insert2CAT(*paths[a]);
         }
     }
     for (auto a : lower_agents)
-    {
-        if (a < 0)
-            path_table.deletePath(-a-1);
-    }
-    runtime_build_CAT = (double)(clock() - t) / CLOCKS_PER_SEC;
+        path_table.deletePath(-a-1);
+    runtime_build_CAT = ((fsec)(Time::now() - t)).count();
 
     // find a path
-    t = clock();
+    t = Time::now();
     Path new_path = search_engines[agent]->findPath(constraint_table);
     for (auto a : lower_agents)
-    {
-        if (a < 0)
-            path_table.insertPath(-a-1);
-    }
-    runtime_path_finding += (double)(clock() - t) / CLOCKS_PER_SEC;
+        path_table.insertPath(-a-1);
+    runtime_path_finding += ((fsec)(Time::now() - t)).count();
     if (screen > 1)
-        cout << "\t\t\tRuntime of single-agent search = " << (double)(clock() - t) / CLOCKS_PER_SEC <<
+        cout << "\t\t\tRuntime of single-agent search = " << ((fsec)(Time::now() - t)).count() <<
              "s with " << search_engines[agent]->getNumExpanded() << " expanded nodes" << endl;
     if (new_path.empty())
     {
@@ -271,98 +263,114 @@ bool PBS::planPath(int agent, PBSNode& node, const set<int> & higher_agents, con
         return false;
     }
     assert(paths[agent] == nullptr or !isSamePath(*paths[agent], new_path));
-    node.new_paths.emplace_back(agent, new_path);
     if (paths[agent] == nullptr)
         node.sum_of_costs += (int)new_path.size() - 1;
     else
         node.sum_of_costs += - (int)paths[agent]->size() + (int)new_path.size();
-    paths[agent] = &node.new_paths.back().second;
+    node.paths.emplace_back(agent, std::move(new_path), paths[agent]);
+    paths[agent] = node.paths.back().path.get();
     return true;
 }
 
-void PBS::topologicalSort(list<int>& stack)
+void PBS::buildPriorities(const PBSNode* node)
 {
-    stack.clear();
-    vector<bool> visited(num_of_agents, false);
-
-    // Call the recursive helper function to store Topological
-    // Sort starting from all vertices one by one
+    // Kahn's algorithm over the priority edges of node and its ancestors,
+    // closing the reachability sets along the way
+    priorities.higher.assign(num_of_agents, AgentSet(num_of_agents));
+    priorities.lower.assign(num_of_agents, AgentSet(num_of_agents));
+    priorities.ordered_agents.clear();
+    priorities.order.assign(num_of_agents, -1);
+    vector<list<int>> direct_lower_agents(num_of_agents);
+    vector<int> num_of_higher_agents(num_of_agents, 0);
+    for (auto curr = node; curr != nullptr; curr = curr->parent)
+    {
+        if (curr->priority.first >= 0 and curr->priority.second >= 0) // internal priority constraint
+        {
+            direct_lower_agents[curr->priority.second].push_back(curr->priority.first);
+            num_of_higher_agents[curr->priority.first]++;
+        }
+    }
     for (int i = 0; i < num_of_agents; i++)
     {
-        if (!visited[i])
-            topologicalSortUtil(i, visited, stack);
+        if (num_of_higher_agents[i] == 0)
+            priorities.ordered_agents.push_back(i);
     }
-    stack.reverse();
-}
-void PBS::topologicalSortUtil(int v, vector<bool> & visited, list<int> & stack)
-{
-    // Mark the current node as visited.
-    visited[v] = true;
-
-    // Recur for all the vertices adjacent to this vertex
-    if (!priorities.empty())
+    for (int k = 0; k < (int)priorities.ordered_agents.size(); k++)
     {
-        for (int i = 0; i < (int) priorities[v].size(); i++)
+        int a = priorities.ordered_agents[k];
+        for (auto a2 : direct_lower_agents[a])
         {
-            if (priorities[v][i] and !visited[i])
-                topologicalSortUtil(i, visited, stack);
+            priorities.higher[a2] |= priorities.higher[a];
+            priorities.higher[a2].set(a);
+            if (--num_of_higher_agents[a2] == 0)
+                priorities.ordered_agents.push_back(a2);
         }
     }
-    // Push current vertex to stack which stores result
-    stack.push_front(v);
-}
-
-void PBS::getHigherPriorityAgents(int agent, set<int>& higher_agents, const list<int> & ordered_agents) const
-{
-    if (agent == ordered_agents.front())
+    if ((int)priorities.ordered_agents.size() < num_of_agents) // cyclic priorities, should not happen
     {
-        higher_agents.insert(higher_external_agents[agent].begin(), higher_external_agents[agent].end());
-        return;
-    }
-
-    auto p = std::find(ordered_agents.begin(), ordered_agents.end(), agent);
-    getHigherPriorityAgents(p, higher_agents, ordered_agents);
-    higher_agents.insert(higher_external_agents[agent].begin(), higher_external_agents[agent].end());
-}
-void PBS::getHigherPriorityAgents(const list<int>::const_iterator & p1, set<int> & higher_agents,
-        const list<int> & ordered_agents) const
-{
-    assert(p1 != ordered_agents.begin());
-    for (auto p2 = std::prev(p1); p2 != ordered_agents.begin(); --p2)
-    {
-        if (priorities[*p1][*p2])
+        for (int i = 0; i < num_of_agents; i++)
         {
-            auto ret = higher_agents.insert(*p2);
-            if (ret.second) // insert successfully
-            {
-                getHigherPriorityAgents(*p2, higher_agents, ordered_agents);
-            }
+            if (num_of_higher_agents[i] > 0)
+                priorities.ordered_agents.push_back(i);
         }
     }
-    if (priorities[*p1][ordered_agents.front()])
+    for (int k = num_of_agents - 1; k >= 0; k--)
     {
-        higher_agents.insert(ordered_agents.front());
+        int a = priorities.ordered_agents[k];
+        priorities.order[a] = k;
+        for (auto a2 : direct_lower_agents[a])
+        {
+            priorities.lower[a] |= priorities.lower[a2];
+            priorities.lower[a].set(a2);
+        }
     }
 }
-void PBS::getLowerPriorityAgents(int agent, set<int>& lower_agents, const list<int> & ordered_agents) const
-{
-    auto p = std::find(ordered_agents.begin(), ordered_agents.end(), agent);
-    getLowerPriorityAgents(p, lower_agents, ordered_agents);
-    lower_agents.insert(lower_external_agents[agent].begin(), lower_external_agents[agent].end());
-}
-void PBS::getLowerPriorityAgents(const list<int>::const_iterator & p1, set<int> & lower_agents,
-        const list<int> & ordered_agents) const
+
+void PBS::addPriority(int lower_agent, int higher_agent)
 {
-    for (auto p2 = std::next(p1); p2 != ordered_agents.end(); ++p2)
+    if (priorities.higher[lower_agent][higher_agent])
+        return; // implied by the existing priorities
+    assert(!priorities.higher[higher_agent][lower_agent]);
+
+    // update the transitive closure
+    auto new_higher = priorities.higher[higher_agent];
+    new_higher.set(higher_agent);
+    auto new_lower = priorities.lower[lower_agent];
+    new_lower.set(lower_agent);
+    for (auto a = new_lower.find_first(); a != AgentSet::npos; a = new_lower.find_next(a))
+        priorities.higher[a] |= new_higher;
+    for (auto a = new_higher.find_first(); a != AgentSet::npos; a = new_higher.find_next(a))
+        priorities.lower[a] |= new_lower;
+
+    // Pearce-Kelly: only the agents between the two positions may need to move
+    int lb = priorities.order[lower_agent];
+    int ub = priorities.order[higher_agent];
+    if (ub < lb)
+        return; // the order is still valid
+    vector<int> slots, moved_forward, moved_backward;
+    for (int k = lb; k <= ub; k++)
     {
-        if (priorities[*p2][*p1])
-        {
-            auto ret = lower_agents.insert(*p2);
-            if (ret.second) // insert successfully
-            {
-                getLowerPriorityAgents(p2, lower_agents, ordered_agents);
-            }
-        }
+        int a = priorities.ordered_agents[k];
+        if (new_higher[a])
+            moved_forward.push_back(a);
+        else if (new_lower[a])
+            moved_backward.push_back(a);
+        else
+            continue;
+        slots.push_back(k);
+    }
+    auto slot = slots.begin();
+    for (auto a : moved_forward)
+    {
+        priorities.ordered_agents[*slot] = a;
+        priorities.order[a] = *slot;
+        ++slot;
+    }
+    for (auto a : moved_backward)
+    {
+        priorities.ordered_agents[*slot] = a;
+        priorities.order[a] = *slot;
+        ++slot;
     }
 }
 
@@ -397,8 +405,9 @@ bool PBS::findInternalConflicts(PBSNode& node, int a1, int a2) const
     }
     return false;
 }
-bool PBS::findExternalConflicts(PBSNode& node, int a, const set<int> & lower_agents) const
+bool PBS::findExternalConflicts(PBSNode& node, int a) const
 {
+    const auto& lower_agents = lower_external_agents[a];
     if (path_table.table.empty())
         return false;
     assert(paths[a] != nullptr and !paths[a]->empty());
@@ -436,7 +445,7 @@ bool PBS::findExternalConflicts(PBSNode& node, int a, const set<int> & lower_age
 
     for (auto c : collisions)
     {
-        if (lower_agents.count(-c-1) == 0)
+        if (std::find(lower_agents.begin(), lower_agents.end(), -c-1) == lower_agents.end())
         {
             node.conflicts.emplace_back(a, c, false);
         }
@@ -450,17 +459,15 @@ bool PBS::findExternalConflicts(PBSNode& node, int a, const set<int> & lower_age
 
 void PBS::update(PBSNode& node)
 {
-    priorities.assign(num_of_agents, vector<bool>(num_of_agents, false));
     higher_external_agents.assign(num_of_agents, list<int>());
     lower_external_agents.assign(num_of_agents, list<int>());
-    paths.assign(num_of_agents, nullptr);
+    switchPaths(paths_node, (const PBSNode*)&node, paths);
+    paths_node = &node;
     for (auto curr = &node; curr != nullptr; curr = curr->parent)
     {
         if (curr->priority.first >= 0)
         {
-            if (curr->priority.second >= 0) // internal priority constraint
-                priorities[curr->priority.first][curr->priority.second] = true;
-            else // external priority constraint
+            if (curr->priority.second < 0) // external priority constraint
                 higher_external_agents[curr->priority.first].push_back(curr->priority.second);
         }
         else
@@ -468,19 +475,30 @@ void PBS::update(PBSNode& node)
             if (curr->priority.second >= 0) // external priority constraint
                 lower_external_agents[curr->priority.second].push_back(curr->priority.first);
         }
-        for (auto & path_pair : curr->new_paths)
-        {
-            if (paths[path_pair.first] == nullptr)
-            {
-                paths[path_pair.first] = &path_pair.second;
-            }
-        }
     }
+
+    // internal priorities: siblings share the priorities of their parent, so build them once per expansion
+    if (node.parent == nullptr)
+    {
+        buildPriorities(&node);
+        parent_of_priorities = nullptr;
+        return;
+    }
+    if (parent_of_priorities == node.parent)
+        priorities = parent_priorities;
+    else
+    {
+        buildPriorities(node.parent);
+        parent_priorities = priorities;
+        parent_of_priorities = node.parent;
+    }
+    if (node.priority.first >= 0 and node.priority.second >= 0)
+        addPriority(node.priority.first, node.priority.second);
 }
 
 inline bool PBS::terminate()
 {
-    runtime = (double)(clock() - start) / CLOCKS_PER_SEC;
+    runtime = ((fsec)(Time::now() - start)).count();
     return open_list.empty() or runtime > time_limit or num_HL_expanded > node_limit or
             open_list.top()->getCollidingPairs() < collsion_threshold;
 }
@@ -489,7 +507,6 @@ inline void PBS::pushNode(PBSNode* node)
 {
     num_HL_generated++;
     node->time_generated = num_HL_generated;
-    all_nodes.push_back(node);
     node->open_handle = open_list.push(node);
     if (best_node == nullptr or node->getCollidingPairs() < best_node->getCollidingPairs())
         best_node = node;
@@ -1,12 +1,14 @@
 #include "RectangleReasoning.h"
+#include "Profiler.h"
 
 
 shared_ptr<Conflict> RectangleReasoning::run(const vector<Path*>& paths, int timestep,
 	int a1, int a2, const MDD* mdd1, const MDD* mdd2)
 {
-	clock_t t = clock();
+	PROFILE_SCOPE("rectangle reasoning");
+	auto t = Time::now();
 	auto rectangle = findRectangleConflictByRM(paths, timestep, a1, a2, mdd1, mdd2);
-	accumulated_runtime += (double)(clock() - t) / CLOCKS_PER_SEC;
+	accumulated_runtime += ((fsec)(Time::now() - t)).count();
 	return rectangle;
 }
 
@@ -69,7 +71,7 @@ shared_ptr<Conflict> RectangleReasoning::findRectangleConflictByGR(const vector<
 
 	if (!blocked(*paths[a1], constraint1) || !blocked(*paths[a2], constraint2))
 		return nullptr;
-	auto rectangle = shared_ptr<Conflict>(new Conflict());
+	auto rectangle = make_shared<Conflict>();
 	rectangle->rectangleConflict(a1, a2, Rs, Rg, Rg_t, constraint1, constraint2);
 	if (type == 2)
 		rectangle->priority = conflict_priority::CARDINAL;
@@ -128,7 +130,7 @@ shared_ptr<Conflict> RectangleReasoning::findRectangleConflictByRM(const vector<
                         {
 							type = new_type;
 							area = new_area;
-							rectangle = shared_ptr<Conflict>(new Conflict());
+							rectangle = make_shared<Conflict>();
 							rectangle->rectangleConflict(a1, a2, Rs, Rg, Rg_t, constraint1, constraint2);
                             if (type == 2)
 							{
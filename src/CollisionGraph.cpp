@@ -0,0 +1,103 @@
+#include "CollisionGraph.h"
+
+CollisionGraph::CollisionGraph(int num_of_vertices) :
+    adj(num_of_vertices), degree_tree(num_of_vertices + 1, 0), position(num_of_vertices, -1) {}
+
+void CollisionGraph::addEdge(int u, int v)
+{
+    if (hasEdge(u, v))
+        return;
+    addToAdjacencyList(u, v);
+    addToAdjacencyList(v, u);
+    num_of_edges++;
+}
+
+void CollisionGraph::removeEdge(int u, int v)
+{
+    if (!hasEdge(u, v))
+        return;
+    removeFromAdjacencyList(u, v);
+    removeFromAdjacencyList(v, u);
+    num_of_edges--;
+}
+
+void CollisionGraph::clear()
+{
+    adj.clear();
+    degree_tree.clear();
+    colliding_vertices.clear();
+    position.clear();
+    num_of_edges = 0;
+}
+
+void CollisionGraph::addToAdjacencyList(int u, int v)
+{
+    auto& neighbors = adj[u];
+    neighbors.insert(std::lower_bound(neighbors.begin(), neighbors.end(), v), v);
+    if (neighbors.size() == 1)
+    {
+        position[u] = (int)colliding_vertices.size();
+        colliding_vertices.push_back(u);
+    }
+    updateDegree(u, 1);
+}
+
+void CollisionGraph::removeFromAdjacencyList(int u, int v)
+{
+    auto& neighbors = adj[u];
+    neighbors.erase(std::lower_bound(neighbors.begin(), neighbors.end(), v));
+    if (neighbors.empty()) // swap with the last colliding vertex
+    {
+        int last = colliding_vertices.back();
+        colliding_vertices[position[u]] = last;
+        position[last] = position[u];
+        colliding_vertices.pop_back();
+        position[u] = -1;
+    }
+    updateDegree(u, -1);
+}
+
+void CollisionGraph::updateDegree(int v, int delta)
+{
+    for (int i = v + 1; i < (int)degree_tree.size(); i += i & (-i))
+        degree_tree[i] += delta;
+}
+
+int CollisionGraph::getVertexByDegree(int r) const
+{
+    assert(0 <= r && r < 2 * num_of_edges);
+    int n = (int)degree_tree.size() - 1;
+    int step = 1;
+    while (step * 2 <= n)
+        step *= 2;
+    int v = 0; // the prefix of the first v vertices has at most r slots
+    for (; step > 0; step /= 2)
+    {
+        if (v + step <= n && degree_tree[v + step] <= r)
+        {
+            v += step;
+            r -= degree_tree[v];
+        }
+    }
+    return v;
+}
+
+void CollisionGraph::getComponent(int v, int max_size, vector<int>& component) const
+{
+    component.clear();
+    unordered_set<int> visited;
+    component.push_back(v);
+    visited.insert(v);
+    for (size_t i = 0; i < component.size() && (int)component.size() <= max_size; i++)
+    {
+        for (int u : adj[component[i]])
+        {
+            if (visited.insert(u).second)
+            {
+                component.push_back(u);
+                if ((int)component.size() > max_size)
+                    return;
+            }
+        }
+    }
+}
@@ -0,0 +1,114 @@
+#include "CompactPath.h"
+#include <algorithm>
+#include <cassert>
+
+CompactPath::CompactPath(const Path& path) : length((int)path.size())
+{
+	if (path.empty())
+		return;
+	last_location = path.back().location;
+	checkpoints.push_back({0, path.front().location, 0});
+	int t = 1;
+	while (t < length)
+	{
+		if ((int)codes.size() >= (int)checkpoints.size() * CHECKPOINT_INTERVAL)
+			checkpoints.push_back({t - 1, path[t - 1].location, (int)codes.size()});
+		int prev = path[t - 1].location;
+		int curr = path[t].location;
+		if (curr == prev)
+		{
+			int waits = 1;
+			while (t + waits < length && path[t + waits].location == prev && waits < UINT16_MAX)
+				waits++;
+			codes.push_back(WAIT);
+			codes.push_back((int16_t)(uint16_t)waits);
+			t += waits;
+			continue;
+		}
+		int delta = curr - prev;
+		if (delta > INT16_MIN && delta <= INT16_MAX)
+			codes.push_back((int16_t)delta);
+		else
+		{
+			codes.push_back(JUMP);
+			codes.push_back((int16_t)(uint16_t)(curr & 0xffff));
+			codes.push_back((int16_t)(uint16_t)((unsigned)curr >> 16));
+		}
+		t++;
+	}
+}
+
+int CompactPath::location(int t) const
+{
+	assert(0 <= t && t < length);
+	// the last checkpoint at or before t
+	auto checkpoint = std::upper_bound(checkpoints.begin(), checkpoints.end(), t,
+		[](int t, const Checkpoint& c) { return t < c.timestep; }) - 1;
+	int curr_t = checkpoint->timestep;
+	int loc = checkpoint->location;
+	int i = checkpoint->code;
+	while (curr_t < t)
+	{
+		int16_t code = codes[i++];
+		if (code == WAIT)
+		{
+			int waits = (uint16_t)codes[i++];
+			if (curr_t + waits >= t)
+				return loc;
+			curr_t += waits;
+			continue;
+		}
+		if (code == JUMP)
+		{
+			loc = (int)((unsigned)(uint16_t)codes[i] | ((unsigned)(uint16_t)codes[i + 1] << 16));
+			i += 2;
+		}
+		else
+			loc += code;
+		curr_t++;
+	}
+	return loc;
+}
+
+void CompactPath::decode(Path& path) const
+{
+	path.clear();
+	path.reserve(length);
+	if (length == 0)
+		return;
+	int loc = checkpoints.front().location;
+	path.emplace_back(loc);
+	for (size_t i = 0; i < codes.size();)
+	{
+		int16_t code = codes[i++];
+		if (code == WAIT)
+		{
+			int waits = (uint16_t)codes[i++];
+			path.insert(path.end(), waits, PathEntry(loc));
+			continue;
+		}
+		if (code == JUMP)
+		{
+			loc = (int)((unsigned)(uint16_t)codes[i] | ((unsigned)(uint16_t)codes[i + 1] << 16));
+			i += 2;
+		}
+		else
+			loc += code;
+		path.emplace_back(loc);
+	}
+	assert((int)path.size() == length);
+}
+
+void CompactPath::save(std::ostream& out) const
+{
+	writeBinary(out, length);
+	writeBinary(out, last_location);
+	writeBinary(out, codes);
+	writeBinary(out, checkpoints);
+}
+
+bool CompactPath::load(std::istream& in)
+{
+	return readBinary(in, length) && readBinary(in, last_location) && readBinary(in, codes) &&
+		readBinary(in, checkpoints);
+}
@@ -20,7 +20,7 @@ int ConstraintTable::getLastCollisionTimestep(int location) const
         rst = path_table_for_CAT->getLastCollisionTimestep(location);
     if (!cat.empty())
     {
-        for (auto t = cat[location].size() - 1; t > rst; t--)
+        for (int t = (int)cat[location].size() - 1; t > rst; t--)
         {
             if (cat[location][t])
                 return t;
@@ -0,0 +1,95 @@
+#include "HeuristicTable.h"
+
+void HeuristicTable::compute(const Instance& instance, int goal_location, int start_location, bool compact)
+{
+	clear();
+	this->instance = &instance;
+	this->compact = compact;
+	if (compact)
+	{
+		this->start_location = start_location;
+		pages.resize((instance.map_size + PAGE_SIZE - 1) >> PAGE_BITS);
+		open.emplace(instance.getManhattanDistance(goal_location, start_location), goal_location);
+		return;
+	}
+
+	struct Node
+	{
+		int location;
+		int value;
+
+		Node() = default;
+		Node(int location, int value) : location(location), value(value) {}
+		// the following is used to compare nodes in the OPEN list
+		struct compare_node
+		{
+			// returns true if n1 > n2 (note -- this gives us *min*-heap).
+			bool operator()(const Node& n1, const Node& n2) const
+			{
+				return n1.value >= n2.value;
+			}
+		};  // used by OPEN (heap) to compare nodes (top of the heap has min f-val, and then highest g-val)
+	};
+
+	distances.assign(instance.map_size, MAX_TIMESTEP);
+
+	// generate a heap that can save nodes (and a open_handle)
+	boost::heap::pairing_heap< Node, boost::heap::compare<Node::compare_node> > heap;
+
+	Node root(goal_location, 0);
+	distances[goal_location] = 0;
+	heap.push(root);  // add root to heap
+	while (!heap.empty())
+	{
+		Node curr = heap.top();
+		heap.pop();
+		for (int next_location : instance.getNeighbors(curr.location))
+		{
+			if (distances[next_location] > curr.value + 1)
+			{
+				distances[next_location] = curr.value + 1;
+				Node next(next_location, curr.value + 1);
+				heap.push(next);
+			}
+		}
+	}
+}
+
+void HeuristicTable::clear()
+{
+	distances.clear();
+	pages.clear();
+	decltype(open)().swap(open);
+}
+
+// As the Manhattan distance to the start location is consistent, a location has its exact distance when it is closed
+int HeuristicTable::resume(int loc) const
+{
+	int rst = MAX_TIMESTEP; // loc is unreachable if the search is exhausted before closing it
+	while (!open.empty())
+	{
+		int curr = open.top().second;
+		int g_val = open.top().first - instance->getManhattanDistance(curr, start_location);
+		open.pop();
+		auto& page = pages[curr >> PAGE_BITS];
+		if (page.empty())
+			page.assign(PAGE_SIZE, UNKNOWN);
+		auto& distance = page[curr & (PAGE_SIZE - 1)];
+		if (distance != UNKNOWN) // closed already
+			continue;
+		distance = (uint16_t)min(g_val, (int)MAX_DISTANCE);
+		for (int next : instance->getNeighbors(curr))
+		{
+			if (lookup(next) == UNKNOWN)
+				open.emplace(g_val + 1 + instance->getManhattanDistance(next, start_location), next);
+		}
+		if (curr == loc)
+		{
+			rst = distance;
+			break;
+		}
+	}
+	if (open.empty()) // all reachable locations are closed
+		decltype(open)().swap(open);
+	return rst;
+}
@@ -3,6 +3,7 @@
 #include <algorithm>
 #include "GCBS.h"
 #include "PBS.h"
+#include "Profiler.h"
 
 InitLNS::InitLNS(const Instance& instance, vector<Agent>& agents, double time_limit,
          const string & replan_algo_name, const string & init_destroy_name, int neighbor_size, int screen, const string & bandit_algorithm_name, int neighborhoodSizes) :
@@ -51,6 +52,7 @@ InitLNS::InitLNS(const Instance& instance, vector<Agent>& agents, double time_li
 bool InitLNS::run()
 {
     start_time = Time::now();
+    path_table.window = window;
     bool succ = getInitialSolution();
     runtime = ((fsec)(Time::now() - start_time)).count();
     iteration_stats.emplace_back(neighbor.agents.size(), sum_of_costs, runtime, "PP", 0, num_of_colliding_pairs);
@@ -73,7 +75,8 @@ bool InitLNS::run()
         paths[i] = &agents[i].path;
     while (runtime < time_limit and num_of_colliding_pairs > 0)
     {
-        assert(instance.validateSolution(paths, sum_of_costs, num_of_colliding_pairs));
+        PROFILE_SCOPE("InitLNS iteration");
+        assert(instance.validateSolution(paths, sum_of_costs, num_of_colliding_pairs, window));
         if (ALNS)
             chooseDestroyHeuristicbyALNS();
 
@@ -99,11 +102,14 @@ bool InitLNS::run()
         neighbor.old_colliding_pairs.clear();
         for (int a : neighbor.agents)
         {
-            for (auto j: collision_graph[a])
+            for (auto j: collision_graph.getNeighbors(a))
             {
-                neighbor.old_colliding_pairs.emplace(min(a, j), max(a, j));
+                neighbor.old_colliding_pairs.emplace_back(min(a, j), max(a, j));
             }
         }
+        std::sort(neighbor.old_colliding_pairs.begin(), neighbor.old_colliding_pairs.end());
+        neighbor.old_colliding_pairs.erase(std::unique(neighbor.old_colliding_pairs.begin(),
+                neighbor.old_colliding_pairs.end()), neighbor.old_colliding_pairs.end());
         if (neighbor.old_colliding_pairs.empty()) // no need to replan
         {
             assert(init_destroy_strategy == RANDOM_BASED);
@@ -120,10 +126,10 @@ bool InitLNS::run()
         for (int i = 0; i < (int)neighbor.agents.size(); i++)
         {
             int a = neighbor.agents[i];
-            if (replan_algo_name == "PP" || neighbor.agents.size() == 1)
-                neighbor.old_paths[i] = agents[a].path;
             path_table.deletePath(neighbor.agents[i]);
             neighbor.old_sum_of_costs += (int) agents[a].path.size() - 1;
+            if (replan_algo_name == "PP") // PP overwrites the paths, so the old ones are swapped out rather than copied
+                neighbor.old_paths[i].swap(agents[a].path);
         }
         if (screen >= 2)
         {
@@ -140,16 +146,19 @@ bool InitLNS::run()
 
         }
 
-        if (replan_algo_name == "PP" || neighbor.agents.size() == 1)
-            succ = runPP();
-        else if (replan_algo_name == "GCBS")
-            succ = runGCBS();
-        else if (replan_algo_name == "PBS")
-            succ = runPBS();
-        else
         {
-            cerr << "Wrong replanning strategy" << endl;
-            exit(-1);
+            PROFILE_SCOPE("repair");
+            if (replan_algo_name == "PP" || neighbor.agents.size() == 1)
+                succ = runPP();
+            else if (replan_algo_name == "GCBS")
+                succ = runGCBS();
+            else if (replan_algo_name == "PBS")
+                succ = runPBS();
+            else
+            {
+                cerr << "Wrong replanning strategy" << endl;
+                exit(-1);
+            }
         }
 
         if (ALNS) // update destroy heuristics
@@ -164,15 +173,9 @@ bool InitLNS::run()
         {
             num_of_colliding_pairs += (int)neighbor.colliding_pairs.size() - (int)neighbor.old_colliding_pairs.size();
             for(const auto& agent_pair : neighbor.old_colliding_pairs)
-            {
-                collision_graph[agent_pair.first].erase(agent_pair.second);
-                collision_graph[agent_pair.second].erase(agent_pair.first);
-            }
+                collision_graph.removeEdge(agent_pair.first, agent_pair.second);
             for(const auto& agent_pair : neighbor.colliding_pairs)
-            {
-                collision_graph[agent_pair.first].emplace(agent_pair.second);
-                collision_graph[agent_pair.second].emplace(agent_pair.first);
-            }
+                collision_graph.addEdge(agent_pair.first, agent_pair.second);
             if (screen >= 2)
                 printCollisionGraph();
         }
@@ -207,12 +210,13 @@ bool InitLNS::runGCBS()
         int agent_id = neighbor.agents[i];
         for (int j = 0; j < instance.getDefaultNumberOfAgents(); j++)
         {
-            if (j != agent_id and collision_graph[agent_id].count(j) == 0)
+            if (j != agent_id and !collision_graph.hasEdge(agent_id, j))
                 path_tables[i].insertPath(j, agents[j].path);
         }
     }
 
     GCBS gcbs(search_engines, screen - 1, &path_tables);
+    gcbs.setSeed(generator());
     gcbs.setDisjointSplitting(false);
     gcbs.setBypass(true);
     gcbs.setTargetReasoning(true);
@@ -300,7 +304,7 @@ bool InitLNS::runPBS()
 bool InitLNS::runPP()
 {
     auto shuffled_agents = neighbor.agents;
-    std::random_shuffle(shuffled_agents.begin(), shuffled_agents.end());
+    std::shuffle(shuffled_agents.begin(), shuffled_agents.end(), generator);
     if (screen >= 2) {
         cout<<"Neighbors_set: ";
         for (auto id : shuffled_agents)
@@ -360,7 +364,7 @@ bool InitLNS::runPP()
             for (int i = 0; i < (int)neighbor.agents.size(); i++)
             {
                 int a = *p2;
-                agents[a].path = neighbor.old_paths[i];
+                agents[a].path.swap(neighbor.old_paths[i]);
                 path_table.insertPath(agents[a].id);
                 ++p2;
             }
@@ -386,9 +390,9 @@ bool InitLNS::getInitialSolution()
         }
     }
     int remaining_agents = (int)neighbor.agents.size();
-    std::random_shuffle(neighbor.agents.begin(), neighbor.agents.end());
+    std::shuffle(neighbor.agents.begin(), neighbor.agents.end(), generator);
     ConstraintTable constraint_table(instance.num_of_cols, instance.map_size, nullptr, &path_table);
-    set<pair<int, int>> colliding_pairs;
+    vector<pair<int, int>> colliding_pairs;
     for (auto id : neighbor.agents)
     {
         agents[id].path = agents[id].path_planner->findPath(constraint_table);
@@ -412,71 +416,62 @@ bool InitLNS::getInitialSolution()
 
     num_of_colliding_pairs = colliding_pairs.size();
     for(const auto& agent_pair : colliding_pairs)
-    {
-        collision_graph[agent_pair.first].emplace(agent_pair.second);
-        collision_graph[agent_pair.second].emplace(agent_pair.first);
-    }
+        collision_graph.addEdge(agent_pair.first, agent_pair.second);
     if (screen >= 2)
         printCollisionGraph();
     return remaining_agents == 0;
 }
 
-// return true if the new p[ath has collisions;
-bool InitLNS::updateCollidingPairs(set<pair<int, int>>& colliding_pairs, int agent_id, const Path& path) const
+// return true if the new path has collisions;
+// the colliding agents are collected in a flat vector and merged into the sorted colliding_pairs
+bool InitLNS::updateCollidingPairs(vector<pair<int, int>>& colliding_pairs, int agent_id, const Path& path) const
 {
-    bool succ = false;
     if (path.size() < 2)
-        return succ;
+        return false;
+    vector<int> colliding_agents; // may contain duplicates
     for (int t = 1; t < (int)path.size(); t++)
     {
         int from = path[t - 1].location;
         int to = path[t].location;
-        if ((int)path_table.table[to].size() > t) // vertex conflicts
+        const auto& to_occupants = path_table.table[to];
+        if ((int)to_occupants.size() > t && t <= path_table.window) // vertex conflicts
+            colliding_agents.insert(colliding_agents.end(), to_occupants[t].begin(), to_occupants[t].end());
+        if (from != to && t <= path_table.window && to_occupants.size() >= t && path_table.table[from].size() > t) // edge conflicts
         {
-            for (auto id : path_table.table[to][t])
+            const auto& from_occupants = path_table.table[from][t];
+            for (auto a1 : to_occupants[t - 1])
             {
-                succ = true;
-                colliding_pairs.emplace(min(agent_id, id), max(agent_id, id));
-            }
-        }
-        if (from != to && path_table.table[to].size() >= t && path_table.table[from].size() > t) // edge conflicts
-        {
-            for (auto a1 : path_table.table[to][t - 1])
-            {
-                for (auto a2: path_table.table[from][t])
-                {
-                    if (a1 == a2)
-                    {
-                        succ = true;
-                        colliding_pairs.emplace(min(agent_id, a1), max(agent_id, a1));
-                        break;
-                    }
-                }
+                if (std::find(from_occupants.begin(), from_occupants.end(), a1) != from_occupants.end())
+                    colliding_agents.push_back(a1);
             }
         }
         if (!path_table.goals.empty() && path_table.goals[to] < t) // target conflicts
         { // this agent traverses the target of another agent
-            for (auto id : path_table.table[to][path_table.goals[to]]) // look at all agents at the goal time
+            for (auto id : to_occupants[path_table.goals[to]]) // look at all agents at the goal time
             {
                 if (agents[id].path.back().location == to) // if agent id's goal is to, then this is the agent we want
                 {
-                    succ = true;
-                    colliding_pairs.emplace(min(agent_id, id), max(agent_id, id));
+                    colliding_agents.push_back(id);
                     break;
                 }
             }
         }
     }
     int goal = path.back().location; // target conflicts - some other agent traverses the target of this agent
-    for (int t = (int)path.size(); t < path_table.table[goal].size(); t++)
-    {
-        for (auto id : path_table.table[goal][t])
-        {
-            succ = true;
-            colliding_pairs.emplace(min(agent_id, id), max(agent_id, id));
-        }
-    }
-    return succ;
+    const auto& goal_occupants = path_table.table[goal];
+    for (int t = (int)path.size(); t < (int)goal_occupants.size(); t++)
+        colliding_agents.insert(colliding_agents.end(), goal_occupants[t].begin(), goal_occupants[t].end());
+    if (colliding_agents.empty())
+        return false;
+
+    std::sort(colliding_agents.begin(), colliding_agents.end());
+    colliding_agents.erase(std::unique(colliding_agents.begin(), colliding_agents.end()), colliding_agents.end());
+    auto middle = colliding_pairs.size();
+    for (int id : colliding_agents) // sorted, as all pairs contain agent_id
+        colliding_pairs.emplace_back(min(agent_id, id), max(agent_id, id));
+    std::inplace_merge(colliding_pairs.begin(), colliding_pairs.begin() + middle, colliding_pairs.end());
+    colliding_pairs.erase(std::unique(colliding_pairs.begin(), colliding_pairs.end()), colliding_pairs.end());
+    return true;
 }
 
 void InitLNS::chooseDestroyHeuristicbyALNS()
@@ -493,28 +488,22 @@ void InitLNS::chooseDestroyHeuristicbyALNS()
 
 bool InitLNS::generateNeighborByCollisionGraph()
 {
-    vector<int> all_vertices;
-    all_vertices.reserve(collision_graph.size());
-    for (int i = 0; i < (int)collision_graph.size(); i++)
-    {
-        if (!collision_graph[i].empty())
-            all_vertices.push_back(i);
-    }
-    unordered_map<int, set<int>> G;
-    auto v = all_vertices[rand() % all_vertices.size()]; // pick a random vertex
-    findConnectedComponent(collision_graph, v, G);
-    assert(G.size() > 1);
+    PROFILE_SCOPE("destroy");
+    // pick a random vertex
+    auto v = collision_graph.getCollidingVertex(getRandomInt(collision_graph.getNumOfCollidingVertices()));
+    vector<int> component; // only explored as far as needed
+    collision_graph.getComponent(v, neighbor_size, component);
+    assert(component.size() > 1);
 
     assert(neighbor_size <= (int)agents.size());
     set<int> neighbors_set;
-    if ((int)G.size() <= neighbor_size)
+    if ((int)component.size() <= neighbor_size)
     {
-        for (const auto& node : G)
-            neighbors_set.insert(node.first);
+        neighbors_set.insert(component.begin(), component.end());
         int count = 0;
         while ((int)neighbors_set.size() < neighbor_size && count < 10)
         {
-            int a1 = *std::next(neighbors_set.begin(), rand() % neighbors_set.size());
+            int a1 = *std::next(neighbors_set.begin(), getRandomInt((int)neighbors_set.size()));
             int a2 = randomWalk(a1);
             if (a2 != NO_AGENT)
                 neighbors_set.insert(a2);
@@ -524,11 +513,14 @@ bool InitLNS::generateNeighborByCollisionGraph()
     }
     else
     {
-        int a = std::next(G.begin(), rand() % G.size())->first;
+        // walk from v, which is a uniformly random vertex of the component just like
+        // picking a random vertex of the component of a random vertex
+        int a = v;
         neighbors_set.insert(a);
         while ((int)neighbors_set.size() < neighbor_size)
         {
-            a = *std::next(G[a].begin(), rand() % G[a].size());
+            const auto& next_agents = collision_graph.getNeighbors(a);
+            a = next_agents[getRandomInt((int)next_agents.size())];
             neighbors_set.insert(a);
         }
     }
@@ -540,19 +532,10 @@ bool InitLNS::generateNeighborByCollisionGraph()
 }
 bool InitLNS::generateNeighborByTarget()
 {
-    int a = -1;
-    auto r = rand() % (num_of_colliding_pairs * 2);
-    int sum = 0;
-    for (int i = 0 ; i < (int)collision_graph.size(); i++)
-    {
-        sum += (int)collision_graph[i].size();
-        if (r <= sum and !collision_graph[i].empty())
-        {
-            a = i;
-            break;
-        }
-    }
-    assert(a != -1 and !collision_graph[a].empty());
+    PROFILE_SCOPE("destroy");
+    // pick an agent with probability proportional to its number of colliding pairs
+    int a = collision_graph.getVertexByDegree(getRandomInt(collision_graph.getNumOfEdges() * 2));
+    assert(collision_graph.getDegree(a) > 0);
     set<pair<int,int>> A_start; // an ordered set of (time, id) pair.
     set<int> A_target;
 
@@ -589,13 +572,13 @@ bool InitLNS::generateNeighborByTarget()
         if (A_start.empty()){
             vector<int> shuffled_agents;
             shuffled_agents.assign(A_target.begin(),A_target.end());
-            std::random_shuffle(shuffled_agents.begin(), shuffled_agents.end());
+            std::shuffle(shuffled_agents.begin(), shuffled_agents.end(), generator);
             neighbors_set.insert(shuffled_agents.begin(), shuffled_agents.begin() + neighbor_size-1);
         }
         else if (A_target.size() >= neighbor_size){
             vector<int> shuffled_agents;
             shuffled_agents.assign(A_target.begin(),A_target.end());
-            std::random_shuffle(shuffled_agents.begin(), shuffled_agents.end());
+            std::shuffle(shuffled_agents.begin(), shuffled_agents.end(), generator);
             neighbors_set.insert(shuffled_agents.begin(), shuffled_agents.begin() + neighbor_size-2);
 
             neighbors_set.insert(A_start.begin()->second);
@@ -619,7 +602,7 @@ bool InitLNS::generateNeighborByTarget()
 
         set<int> tabu_set;
         while(neighbors_set.size()<neighbor_size){
-            int rand_int = rand() % neighbors_set.size();
+            int rand_int = getRandomInt((int)neighbors_set.size());
             auto it = neighbors_set.begin();
             std::advance(it, rand_int);
             a = *it;
@@ -637,7 +620,7 @@ bool InitLNS::generateNeighborByTarget()
 
             if(targets.empty())
                 continue;
-            rand_int = rand() %targets.size();
+            rand_int = getRandomInt((int)targets.size());
             neighbors_set.insert(*(targets.begin()+rand_int));
         }
     }
@@ -651,6 +634,7 @@ bool InitLNS::generateNeighborByTarget()
 }
 bool InitLNS::generateNeighborRandomly()
 {
+    PROFILE_SCOPE("destroy");
     if (neighbor_size >= agents.size())
     {
         neighbor.agents.resize(agents.size());
@@ -658,25 +642,14 @@ bool InitLNS::generateNeighborRandomly()
             neighbor.agents[i] = i;
         return true;
     }
+    // pick agents with probability proportional to their numbers of colliding pairs plus one
     set<int> neighbors_set;
-    auto total = num_of_colliding_pairs * 2 + agents.size();
+    int degree_slots = collision_graph.getNumOfEdges() * 2;
+    int total = degree_slots + (int)agents.size();
     while(neighbors_set.size() < neighbor_size)
     {
-        vector<int> r(neighbor_size - neighbors_set.size());
-        for (auto i = 0; i < neighbor_size - neighbors_set.size(); i++)
-            r[i] = rand() % total;
-        std::sort(r.begin(), r.end());
-        int sum = 0;
-        for (int i = 0, j = 0; i < agents.size() and j < r.size(); i++)
-        {
-            sum += (int)collision_graph[i].size() + 1;
-            if (sum >= r[j])
-            {
-                neighbors_set.insert(i);
-                while (j < r.size() and sum >= r[j])
-                    j++;
-            }
-        }
+        int r = getRandomInt(total);
+        neighbors_set.insert(r < degree_slots ? collision_graph.getVertexByDegree(r) : r - degree_slots);
     }
     neighbor.agents.assign(neighbors_set.begin(), neighbors_set.end());
     if (screen >= 2)
@@ -687,7 +660,7 @@ bool InitLNS::generateNeighborRandomly()
 // Random walk; return the first agent that the agent collides with
 int InitLNS::randomWalk(int agent_id)
 {
-    int t = rand() % agents[agent_id].path.size();
+    int t = getRandomInt((int)agents[agent_id].path.size());
     int loc = agents[agent_id].path[t].location;
     while (t <= path_table.makespan and
            (path_table.table[loc].size() <= t or
@@ -696,15 +669,15 @@ int InitLNS::randomWalk(int agent_id)
     {
         auto next_locs = instance.getNeighbors(loc);
         next_locs.push_back(loc);
-        int step = rand() % next_locs.size();
+        int step = getRandomInt((int)next_locs.size());
         auto it = next_locs.begin();
-        loc = *std::next(next_locs.begin(), rand() % next_locs.size());
+        loc = *std::next(next_locs.begin(), getRandomInt((int)next_locs.size()));
         t = t + 1;
     }
     if (t > path_table.makespan)
         return NO_AGENT;
     else
-        return *std::next(path_table.table[loc][t].begin(), rand() % path_table.table[loc][t].size());
+        return *std::next(path_table.table[loc][t].begin(), getRandomInt((int)path_table.table[loc][t].size()));
 }
 
 void InitLNS::writeIterStatsToFile(const string & file_name) const
@@ -779,9 +752,9 @@ void InitLNS::printCollisionGraph() const
 {
     cout << "Collision graph: ";
     int edges = 0;
-    for (size_t i = 0; i < collision_graph.size(); i++)
+    for (int i = 0; i < collision_graph.size(); i++)
     {
-        for (int j : collision_graph[i])
+        for (int j : collision_graph.getNeighbors(i))
         {
             if (i < j)
             {
@@ -794,25 +767,6 @@ void InitLNS::printCollisionGraph() const
 }
 
 
-unordered_map<int, set<int>>& InitLNS::findConnectedComponent(const vector<set<int>>& graph, int vertex,
-                                                               unordered_map<int, set<int>>& sub_graph)
-{
-    std::queue<int> Q;
-    Q.push(vertex);
-    sub_graph.emplace(vertex, graph[vertex]);
-    while (!Q.empty())
-    {
-        auto v = Q.front(); Q.pop();
-        for (const auto & u : graph[v])
-        {
-            auto ret = sub_graph.emplace(u, graph[u]);
-            if (ret.second) // insert successfully
-                Q.push(u);
-        }
-    }
-    return sub_graph;
-}
-
 void InitLNS::printPath() const
 {
     for (const auto& agent : agents)
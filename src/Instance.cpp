@@ -1,15 +1,123 @@
-#include<boost/tokenizer.hpp>
 #include <algorithm>    // std::shuffle
 #include <random>      // std::default_random_engine
 #include <chrono>       // std::chrono::system_clock
+#include <cstring>
+#include <iomanip>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include"Instance.h"
 #include <nlohmann/json.hpp>
 
 int RANDOM_WALK_STEPS = 100000;
 
+namespace
+{
+// Read-only memory mapping of a whole file
+class MappedFile
+{
+public:
+	explicit MappedFile(const string& fname)
+	{
+		int fd = open(fname.c_str(), O_RDONLY);
+		if (fd < 0)
+			return;
+		struct stat st;
+		if (fstat(fd, &st) == 0 && st.st_size > 0)
+		{
+			void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (addr != MAP_FAILED)
+			{
+				data = (const char*)addr;
+				length = st.st_size;
+			}
+		}
+		close(fd);
+	}
+	~MappedFile() { if (data != nullptr) munmap((void*)data, length); }
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool isOpen() const { return data != nullptr; }
+	const char* begin() const { return data; }
+	const char* end() const { return data + length; }
+	size_t size() const { return length; }
+private:
+	const char* data = nullptr;
+	size_t length = 0;
+};
+
+// Cursor over the text of a map or scen file
+struct TextParser
+{
+	const char* p;
+	const char* end;
+
+	TextParser(const char* begin, const char* end) : p(begin), end(end) {}
+
+	bool lineIsEmpty() const { return p >= end || *p == '\n' || *p == '\r'; }
+	void skipLine()
+	{
+		while (p < end && *p != '\n')
+			p++;
+		if (p < end)
+			p++;
+	}
+	void skipSpaces()
+	{
+		while (p < end && (*p == ' ' || *p == '\t'))
+			p++;
+	}
+	void skipWord()
+	{
+		skipSpaces();
+		while (p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n')
+			p++;
+	}
+	void skipField(char sep)
+	{
+		while (p < end && *p != sep && *p != '\n')
+			p++;
+		if (p < end && *p == sep)
+			p++;
+	}
+	void skipSeparator(char sep)
+	{
+		skipSpaces();
+		if (p < end && *p == sep)
+			p++;
+	}
+	int readInt()
+	{
+		skipSpaces();
+		bool negative = (p < end && *p == '-');
+		if (negative)
+			p++;
+		int value = 0;
+		while (p < end && *p >= '0' && *p <= '9')
+			value = value * 10 + (*p++ - '0');
+		return negative ? -value : value;
+	}
+};
+}
+
+struct Instance::CacheHeader
+{
+	static const uint32_t MAGIC = 0x4650414d; // "MAPF"
+	static const uint32_t VERSION = 1;
+	uint32_t magic;
+	uint32_t version;
+	int a; // rows for maps, agents for scens
+	int b; // cols for maps, map size for scens
+	int c; // nathan benchmark flag for maps
+};
+
 Instance::Instance(const string& map_fname, const string& agent_fname, const string& state_json,
-	int num_of_agents, int num_of_rows, int num_of_cols, int num_of_obstacles, int warehouse_width):
-	map_fname(map_fname), agent_fname(agent_fname), num_of_agents(num_of_agents), state_json(state_json)
+	int num_of_agents, int num_of_rows, int num_of_cols, int num_of_obstacles, int warehouse_width,
+	const string& cache_dir):
+	map_fname(map_fname), agent_fname(agent_fname), num_of_agents(num_of_agents), state_json(state_json),
+	cache_dir(cache_dir)
 {
 	bool succ = loadMap();
 	if (!succ)
@@ -26,6 +134,8 @@ Instance::Instance(const string& map_fname, const string& agent_fname, const str
 			exit(-1);
 		}
 	}
+	buildTopology();
+	buildLandmarks();
 
 	if (state_json == ""){
 		succ = loadAgents();
@@ -99,19 +209,19 @@ void Instance::generateRandomAgents(int warehouse_width)
 		int k = 0;
 		while ( k < num_of_agents)
 		{
-			int x = rand() % num_of_rows, y = rand() % num_of_cols;
+			int x = threadRand() % num_of_rows, y = threadRand() % num_of_cols;
 			int start = linearizeCoordinate(x, y);
 			if (my_map[start] || starts[start])
 				continue;
 
 			// find goal
-            x = rand() % num_of_rows;
-            y = rand() % num_of_cols;
+            x = threadRand() % num_of_rows;
+            y = threadRand() % num_of_cols;
             int goal = linearizeCoordinate(x, y);
             while (my_map[goal] || goals[goal])
             {
-                x = rand() % num_of_rows;
-                y = rand() % num_of_cols;
+                x = threadRand() % num_of_rows;
+                y = threadRand() % num_of_cols;
                 goal = linearizeCoordinate(x, y);
             }
             if (!isConnected(start, goal))
@@ -133,7 +243,7 @@ void Instance::generateRandomAgents(int warehouse_width)
 		int k = 0;
 		while (k < num_of_agents)
 		{
-			int x = rand() % num_of_rows, y = rand() % warehouse_width;
+			int x = threadRand() % num_of_rows, y = threadRand() % warehouse_width;
 			if (k % 2 == 0)
 				y = num_of_cols - y - 1;
 			int start = linearizeCoordinate(x, y);
@@ -149,7 +259,7 @@ void Instance::generateRandomAgents(int warehouse_width)
 		k = 0;
 		while (k < num_of_agents)
 		{
-			int x = rand() % num_of_rows, y = rand() % warehouse_width;
+			int x = threadRand() % num_of_rows, y = threadRand() % warehouse_width;
 			if (k % 2 == 1)
 				y = num_of_cols - y - 1;
 			int goal = linearizeCoordinate(x, y);
@@ -247,62 +357,56 @@ void Instance::generateConnectedRandomGrid(int rows, int cols, int obstacles)
 	i = 0;
 	while (i < obstacles)
 	{
-		int loc = rand() % map_size;
+		int loc = threadRand() % map_size;
 		if (addObstacle(loc))
-		{
-			printMap();
 			i++;
-		}
 	}
 }
 
 bool Instance::loadMap()
 {
-	using namespace boost;
-	using namespace std;
-	ifstream myfile(map_fname.c_str());
-	if (!myfile.is_open())
+	MappedFile file(map_fname);
+	if (!file.isOpen())
 		return false;
-	string line;
-	tokenizer< char_separator<char> >::iterator beg;
-	getline(myfile, line);
-	if (line[0] == 't') // Nathan's benchmark
-	{
-        nathan_benchmark = true;
-		char_separator<char> sep(" ");
-		getline(myfile, line);
-		tokenizer< char_separator<char> > tok(line, sep);
-		beg = tok.begin();
-		beg++;
-		num_of_rows = atoi((*beg).c_str()); // read number of rows
-		getline(myfile, line);
-		tokenizer< char_separator<char> > tok2(line, sep);
-		beg = tok2.begin();
-		beg++;
-		num_of_cols = atoi((*beg).c_str()); // read number of cols
-		getline(myfile, line); // skip "map"
+	string cache_file;
+	if (!cache_dir.empty())
+	{
+		cache_file = getCacheFile("map", getFileKey(map_fname));
+		if (loadMapCache(cache_file))
+			return true;
+	}
+	TextParser parser(file.begin(), file.end());
+	if (*parser.p == 't') // Nathan's benchmark
+	{
+		nathan_benchmark = true;
+		parser.skipLine(); // skip "type octile"
+		parser.skipWord(); // skip "height"
+		num_of_rows = parser.readInt();
+		parser.skipLine();
+		parser.skipWord(); // skip "width"
+		num_of_cols = parser.readInt();
+		parser.skipLine();
+		parser.skipLine(); // skip "map"
 	}
 	else // my benchmark
 	{
-        nathan_benchmark = false;
-		char_separator<char> sep(",");
-		tokenizer< char_separator<char> > tok(line, sep);
-		beg = tok.begin();
-		num_of_rows = atoi((*beg).c_str()); // read number of rows
-		beg++;
-		num_of_cols = atoi((*beg).c_str()); // read number of cols
+		nathan_benchmark = false;
+		num_of_rows = parser.readInt();
+		parser.skipSeparator(',');
+		num_of_cols = parser.readInt();
+		parser.skipLine();
 	}
 	map_size = num_of_cols * num_of_rows;
-	my_map.resize(map_size, false);
+	my_map.assign(map_size, true);
 	// read map (and start/goal locations)
-	for (int i = 0; i < num_of_rows; i++) {
-		getline(myfile, line);
-		for (int j = 0; j < num_of_cols; j++) {
-			my_map[linearizeCoordinate(i, j)] = (line[j] != '.');
-		}
+	for (int i = 0; i < num_of_rows; i++)
+	{
+		for (int j = 0; j < num_of_cols && !parser.lineIsEmpty(); j++, parser.p++)
+			my_map[linearizeCoordinate(i, j)] = (*parser.p != '.');
+		parser.skipLine();
 	}
-	myfile.close();
-
+	if (!cache_file.empty())
+		saveMapCache(cache_file);
 	return true;
 }
 
@@ -350,15 +454,18 @@ void Instance::saveMap() const
 
 bool Instance::loadAgents()
 {
-	using namespace std;
-	using namespace boost;
-
-	string line;
-	ifstream myfile (agent_fname.c_str());
-	if (!myfile.is_open()) 
-	return false;
-
-	getline(myfile, line);
+	MappedFile file(agent_fname);
+	if (!file.isOpen())
+		return false;
+	string cache_file;
+	if (!cache_dir.empty())
+	{
+		cache_file = getCacheFile("agents", getFileKey(agent_fname) + getFileKey(map_fname) +
+			std::to_string(num_of_agents));
+		if (loadAgentsCache(cache_file))
+			return true;
+	}
+	TextParser parser(file.begin(), file.end());
 	if (nathan_benchmark) // Nathan's benchmark
 	{
 		if (num_of_agents == 0)
@@ -366,66 +473,154 @@ bool Instance::loadAgents()
 			cerr << "The number of agents should be larger than 0" << endl;
 			return false;
 		}
+		parser.skipLine(); // skip "version 1"
 		start_locations.resize(num_of_agents);
 		goal_locations.resize(num_of_agents);
-		char_separator<char> sep("\t");
 		for (int i = 0; i < num_of_agents; i++)
 		{
-			getline(myfile, line);
-			if (line.empty())
-            {
-			    cerr << "Error! The instance has only " << i << " agents" << endl;
-			    return false;
-            }
-			tokenizer< char_separator<char> > tok(line, sep);
-			tokenizer< char_separator<char> >::iterator beg = tok.begin();
-			beg++; // skip the first number
-			beg++; // skip the map name
-			beg++; // skip the columns
-			beg++; // skip the rows
-				   // read start [row,col] for agent i
-			int col = atoi((*beg).c_str());
-			beg++;
-			int row = atoi((*beg).c_str());
+			if (parser.lineIsEmpty())
+			{
+				cerr << "Error! The instance has only " << i << " agents" << endl;
+				return false;
+			}
+			// skip the bucket, the map name, the columns and the rows
+			for (int k = 0; k < 4; k++)
+				parser.skipField('\t');
+			// read start [row,col] for agent i
+			int col = parser.readInt();
+			int row = parser.readInt();
 			start_locations[i] = linearizeCoordinate(row, col);
 			// read goal [row,col] for agent i
-			beg++;
-			col = atoi((*beg).c_str());
-			beg++;
-			row = atoi((*beg).c_str());
+			col = parser.readInt();
+			row = parser.readInt();
 			goal_locations[i] = linearizeCoordinate(row, col);
+			parser.skipLine();
 		}
 	}
 	else // My benchmark
 	{
-		char_separator<char> sep(",");
-		tokenizer< char_separator<char> > tok(line, sep);
-		tokenizer< char_separator<char> >::iterator beg = tok.begin();
-		num_of_agents = atoi((*beg).c_str());
+		num_of_agents = parser.readInt();
+		parser.skipLine();
 		start_locations.resize(num_of_agents);
 		goal_locations.resize(num_of_agents);
-		for (int i = 0; i<num_of_agents; i++)
+		for (int i = 0; i < num_of_agents; i++)
 		{
-			getline(myfile, line);
-			tokenizer< char_separator<char> > col_tok(line, sep);
-			tokenizer< char_separator<char> >::iterator c_beg = col_tok.begin();
-			pair<int, int> curr_pair;
 			// read start [row,col] for agent i
-			int row = atoi((*c_beg).c_str());
-			c_beg++;
-			int col = atoi((*c_beg).c_str());
+			int row = parser.readInt();
+			parser.skipSeparator(',');
+			int col = parser.readInt();
+			parser.skipSeparator(',');
 			start_locations[i] = linearizeCoordinate(row, col);
 			// read goal [row,col] for agent i
-			c_beg++;
-			row = atoi((*c_beg).c_str());
-			c_beg++;
-			col = atoi((*c_beg).c_str());
+			row = parser.readInt();
+			parser.skipSeparator(',');
+			col = parser.readInt();
 			goal_locations[i] = linearizeCoordinate(row, col);
+			parser.skipLine();
 		}
 	}
-	myfile.close();
+	if (!cache_file.empty())
+		saveAgentsCache(cache_file);
+	return true;
+}
+
+
+// The cache files are named by a hash of the canonical path, size and modification time of the input files,
+// so a modified map or scen file is parsed again.
+string Instance::getFileKey(const string& fname)
+{
+	struct stat st;
+	if (stat(fname.c_str(), &st) != 0)
+		return fname;
+	char* path = realpath(fname.c_str(), nullptr);
+	string key = (path == nullptr ? fname : string(path)) + ":" + std::to_string(st.st_size) + ":" +
+		std::to_string(st.st_mtim.tv_sec) + "." + std::to_string(st.st_mtim.tv_nsec);
+	free(path);
+	return key;
+}
+
+
+string Instance::getCacheFile(const string& kind, const string& key) const
+{
+	uint64_t hash = 14695981039346656037ULL; // FNV-1a
+	for (char c : key)
+	{
+		hash ^= (unsigned char)c;
+		hash *= 1099511628211ULL;
+	}
+	std::ostringstream name;
+	name << cache_dir << "/" << kind << "-" << std::hex << std::setw(16) << std::setfill('0') << hash << ".bin";
+	return name.str();
+}
+
+
+bool Instance::loadMapCache(const string& fname)
+{
+	MappedFile file(fname);
+	CacheHeader header;
+	if (!file.isOpen() || file.size() < sizeof(header))
+		return false;
+	memcpy(&header, file.begin(), sizeof(header));
+	size_t size = (size_t)header.a * header.b;
+	if (header.magic != CacheHeader::MAGIC || header.version != CacheHeader::VERSION ||
+		file.size() != sizeof(header) + (size + 7) / 8)
+		return false;
+	num_of_rows = header.a;
+	num_of_cols = header.b;
+	nathan_benchmark = header.c;
+	map_size = num_of_rows * num_of_cols;
+	my_map.resize(map_size);
+	auto bits = (const unsigned char*)file.begin() + sizeof(header);
+	for (int i = 0; i < map_size; i++)
+		my_map[i] = (bits[i / 8] >> (i % 8)) & 1;
 	return true;
+}
+
 
+void Instance::saveMapCache(const string& fname) const
+{
+	CacheHeader header{CacheHeader::MAGIC, CacheHeader::VERSION, num_of_rows, num_of_cols, nathan_benchmark};
+	vector<unsigned char> bits((map_size + 7) / 8, 0);
+	for (int i = 0; i < map_size; i++)
+	{
+		if (my_map[i])
+			bits[i / 8] |= 1 << (i % 8);
+	}
+	ofstream out(fname, std::ios::binary);
+	out.write((const char*)&header, sizeof(header));
+	out.write((const char*)bits.data(), bits.size());
+	if (!out)
+		cerr << "Fail to save the map cache to " << fname << endl;
+}
+
+
+bool Instance::loadAgentsCache(const string& fname)
+{
+	MappedFile file(fname);
+	CacheHeader header;
+	if (!file.isOpen() || file.size() < sizeof(header))
+		return false;
+	memcpy(&header, file.begin(), sizeof(header));
+	if (header.magic != CacheHeader::MAGIC || header.version != CacheHeader::VERSION ||
+		header.b != map_size || file.size() != sizeof(header) + 2 * sizeof(int) * (size_t)header.a)
+		return false;
+	num_of_agents = header.a;
+	auto data = (const int*)(file.begin() + sizeof(header));
+	start_locations.assign(data, data + num_of_agents);
+	goal_locations.assign(data + num_of_agents, data + 2 * num_of_agents);
+	return true;
+}
+
+
+void Instance::saveAgentsCache(const string& fname) const
+{
+	CacheHeader header{CacheHeader::MAGIC, CacheHeader::VERSION, num_of_agents, map_size, 0};
+	ofstream out(fname, std::ios::binary);
+	out.write((const char*)&header, sizeof(header));
+	out.write((const char*)start_locations.data(), sizeof(int) * num_of_agents);
+	out.write((const char*)goal_locations.data(), sizeof(int) * num_of_agents);
+	if (!out)
+		cerr << "Fail to save the agents cache to " << fname << endl;
 }
 
 
@@ -473,6 +668,158 @@ void Instance::saveNathan() const
 }
 
 
+void Instance::buildTopology()
+{
+	degrees.assign(map_size, 0);
+	for (int loc = 0; loc < map_size; loc++)
+	{
+		if (my_map[loc])
+			continue;
+		if (0 <= loc - num_of_cols && !my_map[loc - num_of_cols])
+			degrees[loc]++;
+		if (loc + num_of_cols < map_size && !my_map[loc + num_of_cols])
+			degrees[loc]++;
+		if (loc % num_of_cols > 0 && !my_map[loc - 1])
+			degrees[loc]++;
+		if (loc % num_of_cols < num_of_cols - 1 && !my_map[loc + 1])
+			degrees[loc]++;
+	}
+
+	// walk along the chain of each unvisited corridor cell in both directions
+	corridor_ids.assign(map_size, -1);
+	corridors.clear();
+	for (int loc = 0; loc < map_size; loc++)
+	{
+		if (my_map[loc] || degrees[loc] != 2 || corridor_ids[loc] >= 0)
+			continue;
+		int id = (int)corridors.size();
+		corridors.push_back({{-1, -1}, 0});
+		auto& corridor = corridors.back();
+		corridor_ids[loc] = id;
+		int num_of_cells = 1;
+		auto neighbors = getNeighbors(loc);
+		int i = 0;
+		for (int next : neighbors)
+		{
+			int prev = loc;
+			int curr = next;
+			while (degrees[curr] == 2 && corridor_ids[curr] < 0)
+			{
+				corridor_ids[curr] = id;
+				num_of_cells++;
+				for (int n : getNeighbors(curr))
+				{
+					if (n != prev)
+					{
+						prev = curr;
+						curr = n;
+						break;
+					}
+				}
+			}
+			if (degrees[curr] != 2) // otherwise, the chain is a cycle
+				corridor.ends[i] = curr;
+			i++;
+		}
+		corridor.length = num_of_cells + 1;
+	}
+
+	intersections.clear();
+	intersection_offsets.assign(map_size + 1, 0);
+	intersection_adjacency.clear();
+	for (int loc = 0; loc < map_size; loc++)
+	{
+		intersection_offsets[loc] = (int)intersection_adjacency.size();
+		if (my_map[loc] || degrees[loc] <= 2)
+			continue;
+		intersections.push_back(loc);
+		auto begin = intersection_adjacency.size();
+		for (int next : getNeighbors(loc))
+		{
+			int other = next;
+			if (degrees[next] == 2)
+			{
+				const auto& corridor = corridors[corridor_ids[next]];
+				other = (corridor.ends[0] == loc) ? corridor.ends[1] : corridor.ends[0];
+			}
+			if (other >= 0 && other != loc && degrees[other] > 2)
+				intersection_adjacency.push_back(other);
+		}
+		std::sort(intersection_adjacency.begin() + begin, intersection_adjacency.end());
+		intersection_adjacency.erase(std::unique(intersection_adjacency.begin() + begin, intersection_adjacency.end()),
+			intersection_adjacency.end());
+	}
+	intersection_offsets[map_size] = (int)intersection_adjacency.size();
+}
+
+
+// select the landmarks by farthest-point sampling, i.e., each landmark is the cell that is the farthest
+// from the landmarks selected before it, so the landmarks spread over the map (and its components)
+void Instance::buildLandmarks()
+{
+	vector<int> distances(map_size);
+	vector<int> min_distances(map_size, MAX_TIMESTEP); // the distance to the nearest landmark
+	vector<int> queue(map_size);
+	int next_landmark = -1;
+	for (int loc = 0; loc < map_size && next_landmark < 0; loc++)
+	{
+		if (!my_map[loc])
+			next_landmark = loc;
+	}
+	num_of_landmarks = 0;
+	landmark_distances.clear();
+	for (int i = 0; i <= MAX_NUM_OF_LANDMARKS && next_landmark >= 0; i++)
+	{
+		// BFS from the next landmark
+		std::fill(distances.begin(), distances.end(), MAX_TIMESTEP);
+		distances[next_landmark] = 0;
+		queue[0] = next_landmark;
+		int head = 0, tail = 1;
+		while (head < tail)
+		{
+			int curr = queue[head++];
+			int candidates[4] = {curr + 1, curr - 1, curr + num_of_cols, curr - num_of_cols};
+			for (int next : candidates)
+			{
+				if (validMove(curr, next) && distances[next] == MAX_TIMESTEP)
+				{
+					distances[next] = distances[curr] + 1;
+					queue[tail++] = next;
+				}
+			}
+		}
+		if (i > 0) // the first BFS is only used to find a peripheral cell
+		{
+			num_of_landmarks++;
+			landmark_distances.resize(landmark_distances.size() + map_size);
+			std::copy(distances.begin(), distances.end(), landmark_distances.end() - map_size);
+			for (int loc = 0; loc < map_size; loc++)
+				min_distances[loc] = min(min_distances[loc], distances[loc]);
+		}
+		next_landmark = -1;
+		int farthest = 0;
+		for (int loc = 0; loc < map_size; loc++)
+		{
+			int d = (i > 0) ? min_distances[loc] : distances[loc];
+			if (!my_map[loc] && d > farthest && (i > 0 || d < MAX_TIMESTEP))
+			{
+				farthest = d;
+				next_landmark = loc;
+			}
+		}
+	}
+
+	// transpose the table, so the distances of a location are next to each other
+	vector<int> table(landmark_distances.size());
+	for (int i = 0; i < num_of_landmarks; i++)
+	{
+		for (int loc = 0; loc < map_size; loc++)
+			table[loc * num_of_landmarks + i] = landmark_distances[i * map_size + loc];
+	}
+	landmark_distances.swap(table);
+}
+
+
 list<int> Instance::getNeighbors(int curr) const
 {
 	list<int> neighbors;
@@ -505,7 +852,7 @@ void Instance::savePaths(const string & file_name, const vector<Path*>& paths) c
     output.close();
 }
 
-bool Instance::validateSolution(const vector<Path*>& paths, int sum_of_costs, int num_of_colliding_pairs) const
+bool Instance::validateSolution(const vector<Path*>& paths, int sum_of_costs, int num_of_colliding_pairs, int window) const
 {
     cout << "Validate solution ..." << endl;
     if (paths.size() != start_locations.size())
@@ -561,7 +908,7 @@ bool Instance::validateSolution(const vector<Path*>& paths, int sum_of_costs, in
             const auto a1 = paths[i]->size() <= paths[j]->size()? i : j;
             const auto a2 = paths[i]->size() <= paths[j]->size()? j : i;
             int t = 1;
-            for (; t < (int) paths[a1]->size(); t++)
+            for (; t < (int) paths[a1]->size() && t <= window; t++)
             {
                 if (paths[a1]->at(t).location == paths[a2]->at(t).location) // vertex conflict
                 {
@@ -593,7 +940,7 @@ bool Instance::validateSolution(const vector<Path*>& paths, int sum_of_costs, in
             if (!found_collision)
             {
                 auto target = paths[a1]->back().location;
-                for (; t < (int) paths[a2]->size(); t++)
+                for (t = (int) paths[a1]->size(); t < (int) paths[a2]->size(); t++)
                 {
                     if (paths[a2]->at(t).location == target)  // target conflict
                     {
@@ -1,15 +1,19 @@
 #include "LNS.h"
 #include "ECBS.h"
+#include "Profiler.h"
+#include "CompactPath.h"
 #include <queue>
 #include <random>
 #include <array>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include <nlohmann/json.hpp>
+#include <sstream>
+#include <cstdio>
 
-int getRandomFromSetExp() {
+int getRandomFromSetExp(std::mt19937& gen) {
     std::array<int, 5> values = {2, 4, 8, 16, 32};
-    // Random number generator
-    std::random_device rd;
-    std::mt19937 gen(rd());
     std::uniform_int_distribution<> distrib(0, values.size() - 1);
 
     // Generate random index and return the value at that index
@@ -17,10 +21,7 @@ int getRandomFromSetExp() {
     return values[randomIndex];
 }
 
-int getRandomFromRange() {
-    // Random number generator
-    std::random_device rd;
-    std::mt19937 gen(rd());
+int getRandomFromRange(std::mt19937& gen) {
     std::uniform_int_distribution<> distrib(5, 16); // Adjusted to cover the range [5, 16]
 
     // Generate and return a random number from the range [0, 31]
@@ -62,6 +63,14 @@ LNS::LNS(const Instance& instance, double time_limit, const string & init_algo_n
         }
     }
 
+    if (replan_algo_name == "Adaptive")
+        repair_algos = {"PP", "PIBT", "winPIBT"};
+    else
+        repair_algos = {replan_algo_name};
+    repairBanditStats.destroy_weights.assign(repair_algos.size(), 1);
+    repairBanditStats.destroy_weights_squared.assign(repair_algos.size(), 1);
+    repairBanditStats.destroy_counts.assign(repair_algos.size(), 0);
+
     if (destroy_name == "Adaptive")
         ALNS = true;
     else if (destroy_name == "RandomWalk")
@@ -80,8 +89,20 @@ LNS::LNS(const Instance& instance, double time_limit, const string & init_algo_n
         cout << "Pre-processing time = " << preprocessing_time << " seconds." << endl;
 }
 
-bool LNS::run()
+LNS::LNS(const LNS& other, const string & init_algo_name) :
+         BasicLNS(other.instance, other.time_limit, other.neighbor_size, other.screen, other.bandit_algorithm_name, 0, DESTROY_COUNT),
+         agents(other.agents), replan_time_limit(other.replan_time_limit),
+         init_algo_name(init_algo_name), replan_algo_name(other.replan_algo_name), use_init_lns(false),
+         num_of_iterations(0), init_destroy_name(other.init_destroy_name), pipp_option(other.pipp_option),
+         path_table(other.instance.map_size)
+{
+    start_time = other.start_time; // share the parent's clock so that the time limit stays global
+}
+
+bool LNS::initializeSolution()
 {
+    PROFILE_SCOPE("initial solution");
+    path_table.window = window;
     // only for statistic analysis, and thus is not included in runtime
     sum_of_distances = 0;
     for (const auto & agent : agents)
@@ -89,6 +110,7 @@ bool LNS::run()
         sum_of_distances += agent.path_planner->my_heuristic[agent.path_planner->start_location];
     }
 
+    threadRandomEngine().seed(seed); // heap tie-breaking in the low-level and high-level searches
     bool succ = false;
     initial_solution_runtime = 0;
     start_time = Time::now();
@@ -99,9 +121,13 @@ bool LNS::run()
         {
             if (use_init_lns)
             {
+                // InitLNS repairs collisions, which the PIBT-based operators cannot do
+                bool pibt_repair = replan_algo_name == "Adaptive" || replan_algo_name == "PIBT" || replan_algo_name == "winPIBT";
                 init_lns = new InitLNS(instance, agents, time_limit - initial_solution_runtime,
-                        replan_algo_name,init_destroy_name, neighbor_size, screen, bandit_algorithm_name, numberOfNeighborhoodSizeCandidates);
+                        pibt_repair ? "PP" : replan_algo_name,init_destroy_name, neighbor_size, screen, bandit_algorithm_name, numberOfNeighborhoodSizeCandidates);
                 init_lns->replan_time_limit = replan_time_limit;
+                init_lns->window = window;
+                init_lns->setSeed(generator());
                 succ = init_lns->run();
                 if (succ) // accept new paths
                 {
@@ -141,8 +167,8 @@ bool LNS::run()
                 auto loc = instance.num_of_cols * row + col;
                 path.emplace_back(PathEntry(loc));
             }
-            agents[id].path = path;
-            neighbor.sum_of_costs += path.size() - 1;
+            agents[id].path = std::move(path);
+            neighbor.sum_of_costs += agents[id].path.size() - 1;
             path_table.insertPath(agents[id].id, agents[id].path);
         }
         succ = true;
@@ -167,146 +193,449 @@ bool LNS::run()
              << runtime << " seconds after  " << restart_times << " restarts" << endl;
         return false; // terminate because no initial solution is found
     }
-    double lns_runtime = 0;
+    return true;
+}
+
+bool LNS::run()
+{
+    if (!resume or checkpoint_file.empty() or !loadCheckpoint())
+    {
+        if (!initializeSolution())
+            return false;
+        lns_runtime = 0;
+    }
+    auto checkpoint_time = Time::now();
     while (lns_runtime < time_limit or iteration_stats.size() <= num_of_iterations)
     {
+        runIteration();
+        if (checkpoint_interval > 0 and !checkpoint_file.empty() and
+            ((fsec)(Time::now() - checkpoint_time)).count() >= checkpoint_interval)
+        {
+            saveCheckpoint();
+            checkpoint_time = Time::now();
+        }
+    }
+    if (!checkpoint_file.empty())
+        saveCheckpoint();
 
+    average_group_size = - iteration_stats.front().num_of_agents;
+    for (const auto& data : iteration_stats)
+        average_group_size += data.num_of_agents;
+    if (average_group_size > 0)
+        average_group_size /= (double)(iteration_stats.size() - 1);
+        
+    int sum_of_delay = 0;
+    for (int i = 0; i < agents.size(); i++){
+        sum_of_delay += agents[i].getNumOfDelays();
+    }
+
+    cout << getSolverName() << ": Iterations = " << iteration_stats.size() << ", "
+         << "solution cost = " << sum_of_costs << ", "
+         << "initial solution cost = " << initial_sum_of_costs << ", "
+         << "lns_runtime = " << lns_runtime << ", "
+         << "group size = " << average_group_size << ", "
+         << "failed iterations = " << num_of_failures << ", sum_of_delay = " << sum_of_delay << endl;
+    return true;
+}
 
-        runtime =((fsec)(Time::now() - start_time)).count();
-        if(screen >= 1)
+bool LNS::runLifelong()
+{
+    if (!checkpoint_file.empty())
+    {
+        cerr << "Checkpoints are not supported in lifelong mode." << endl;
+        exit(-1);
+    }
+    goal_input.open(goal_stream);
+    if (!goal_input.is_open())
+    {
+        cerr << "Goal stream " << goal_stream << " not found." << endl;
+        exit(-1);
+    }
+    if (horizon < 1 or horizon > window)
+    {
+        cerr << "The horizon of lifelong mode must be positive and no larger than the window." << endl;
+        exit(-1);
+    }
+    if (!initializeSolution())
+        return false;
+    replan_time_limit = min(replan_time_limit, tick_time); // bound the latency of a tick
+    executed_paths.resize(agents.size());
+    for (const auto& agent : agents)
+        executed_paths[agent.id].assign(1, agent.path.front());
+    lns_runtime = 0;
+    double max_tick_runtime = 0;
+    int tick = 0;
+    while ((num_of_ticks <= 0 or tick < num_of_ticks) and runtime < time_limit)
+    {
+        PROFILE_SCOPE("tick");
+        auto tick_start = Time::now();
+        while (sum_of_costs > 0 and ((fsec)(Time::now() - tick_start)).count() < tick_time and runtime < time_limit)
+            runIteration();
+        if (!commitPrefix())
+        {
+            cout << "Failed to resolve the conflicts that enter the window at tick " << tick << endl;
+            return false;
+        }
+        bool assigned = assignGoals();
+        tick++;
+        double tick_runtime = ((fsec)(Time::now() - tick_start)).count();
+        max_tick_runtime = max(max_tick_runtime, tick_runtime);
+        runtime = ((fsec)(Time::now() - start_time)).count();
+        if (screen >= 1)
             validateSolution();
+        cout << "Tick " << tick << ", finished tasks = " << num_of_finished_tasks << ", "
+             << "solution cost = " << sum_of_costs << ", tick runtime = " << tick_runtime << endl;
+        if (num_of_ticks <= 0 and sum_of_costs == 0 and !assigned) // all agents are at their goals
+            break;
+    }
+    cout << getSolverName() << ": Ticks = " << tick << ", "
+         << "finished tasks = " << num_of_finished_tasks << ", "
+         << "pending goals = " << pending_goals.size() << ", "
+         << "iterations = " << iteration_stats.size() << ", "
+         << "runtime = " << runtime << ", "
+         << "max tick runtime = " << max_tick_runtime << endl;
+    return true;
+}
 
+struct CheckpointHeader
+{
+    static const uint32_t MAGIC = 0x43534e4c; // "LNSC"
+    static const uint32_t VERSION = 1;
+    uint32_t magic;
+    uint32_t version;
+    int num_of_agents;
+    int map_size;
+};
 
-        auto removal_start = Time::now();
+// the checkpoint is written to a temporary file first, so a run that is killed while writing keeps the old one
+void LNS::saveCheckpoint() const
+{
+    PROFILE_SCOPE("checkpoint");
+    string tmp_file = checkpoint_file + ".tmp";
+    ofstream out(tmp_file, std::ios::binary);
+    CheckpointHeader header{CheckpointHeader::MAGIC, CheckpointHeader::VERSION, (int)agents.size(), instance.map_size};
+    writeBinary(out, header);
+    saveState(out);
+    writeBinary(out, initial_sum_of_costs);
+    writeBinary(out, initial_solution_runtime);
+    writeBinary(out, sum_of_distances);
+    writeBinary(out, restart_times);
+    writeBinary(out, lns_runtime);
+    saveBanditStats(out, repairBanditStats);
+    writeBinary(out, vector<int>(tabu_list.begin(), tabu_list.end()));
+    std::ostringstream engine;
+    engine << threadRandomEngine();
+    writeBinary(out, engine.str());
+    for (const auto& agent : agents)
+        CompactPath(agent.path).save(out);
+    out.close();
+    if (!out || std::rename(tmp_file.c_str(), checkpoint_file.c_str()) != 0)
+        cerr << "Fail to save the checkpoint to " << checkpoint_file << endl;
+}
 
-        sampleDestroyHeuristicAndNeighborhoodSize(); // only sample the nb size
+bool LNS::loadCheckpoint()
+{
+    std::ifstream in(checkpoint_file, std::ios::binary);
+    if (!in.is_open())
+        return false;
+    CheckpointHeader header;
+    vector<int> tabu_agents;
+    string engine;
+    vector<CompactPath> paths(agents.size());
+    bool succ = readBinary(in, header) && header.magic == CheckpointHeader::MAGIC &&
+            header.version == CheckpointHeader::VERSION && header.num_of_agents == (int)agents.size() &&
+            header.map_size == instance.map_size &&
+            loadState(in) && readBinary(in, initial_sum_of_costs) && readBinary(in, initial_solution_runtime) &&
+            readBinary(in, sum_of_distances) && readBinary(in, restart_times) && readBinary(in, lns_runtime) &&
+            loadBanditStats(in, repairBanditStats) && readBinary(in, tabu_agents) && readBinary(in, engine);
+    for (auto& path : paths)
+        succ = succ && path.load(in);
+    if (!succ)
+    {
+        cerr << "Checkpoint " << checkpoint_file << " is corrupted or does not match the instance and the settings." << endl;
+        exit(-1);
+    }
+    tabu_list.clear();
+    tabu_list.insert(tabu_agents.begin(), tabu_agents.end());
+    std::istringstream(engine) >> threadRandomEngine();
+    path_table.window = window;
+    path_table.reset();
+    for (auto& agent : agents)
+    {
+        paths[agent.id].decode(agent.path);
+        path_table.insertPath(agent.id, agent.path);
+    }
+    // runtime continues from the checkpoint
+    start_time = Time::now() - std::chrono::duration_cast<Time::duration>(std::chrono::duration<double>(runtime));
+    cout << "Resume from " << checkpoint_file << " at iteration " << iteration_stats.size() << ", "
+         << "solution cost = " << sum_of_costs << ", lns_runtime = " << lns_runtime << endl;
+    return true;
+}
 
-        if (uniform_neighbor==0){ // use the specified nb_size
-            neighbor_size = specified_neighbor ;
-        }
-        else if (uniform_neighbor==1){ // sample from {2,4,8,16,32}
-            neighbor_size =getRandomFromSetExp();
-        }
-        else if (uniform_neighbor==2){ // sample a random int from range 5 ~ 16
-            neighbor_size =getRandomFromRange();
-        }
+// advances all agents by horizon timesteps and drops the executed prefixes from the plan
+bool LNS::commitPrefix()
+{
+    PROFILE_SCOPE("commit");
+    for (auto& agent : agents)
+    {
+        auto& path = agent.path;
+        int steps = min(horizon, (int)path.size() - 1);
+        auto& executed = executed_paths[agent.id];
+        executed.insert(executed.end(), path.begin() + 1, path.begin() + steps + 1);
+        executed.resize(executed.size() + horizon - steps, path[steps]); // wait at the goal
+        if (steps > 0 and steps == (int)path.size() - 1)
+            num_of_finished_tasks++;
+        path.erase(path.begin(), path.begin() + steps);
+        agent.path_planner->start_location = path.front().location;
+    }
 
-        switch (destroy_strategy)
+    // the window has moved forward, so the moving agents whose paths now conflict inside it are replanned
+    // (the agents at their goals are inserted first, as they cannot move)
+    path_table.reset();
+    sum_of_costs = 0;
+    vector<int> moving_agents;
+    for (const auto& agent : agents)
+    {
+        if (agent.path.size() == 1)
+            path_table.insertPath(agent.id, agent.path);
+        else
+            moving_agents.push_back(agent.id);
+    }
+    neighbor.agents.clear();
+    for (int a : moving_agents)
+    {
+        if (window < MAX_TIMESTEP and !isConsistentWithPathTable(agents[a].path))
         {
-
-            case RANDOMWALK:
-                succ = generateNeighborByRandomWalk();
-                if (not succ){
-                    cout << "RANDOMWALK Failed to generate a neighbor" << endl;
-                }
-                break;
-            case INTERSECTION:
-                succ = generateNeighborByIntersection();
-                if (not succ){
-                    cout << "INTERSECTION Failed to generate a neighbor" << endl;
-                }
-                break;
-            case RANDOMAGENTS:
-                neighbor.agents.resize(agents.size());
-                for (int i = 0; i < (int)agents.size(); i++)
-                    neighbor.agents[i] = i;
-                if (neighbor.agents.size() > neighbor_size)
-                {
-                    std::random_shuffle(neighbor.agents.begin(), neighbor.agents.end());
-                    neighbor.agents.resize(neighbor_size);
-                }
-                assert(neighbor.agents.size() > 0);
-                succ = true;
-                if (not succ){
-                    cout << "RANDOMAGENTS Failed to generate a neighbor" << endl;
-                }
-                break;
-            default:
-                cerr << "Wrong neighbor generation strategy" << endl;
-                exit(-1);
-        }
-        auto removal_time =  ((fsec)(Time::now() - removal_start)).count() ;
-        searchSuccess = succ? 1 : 0;
-        if(!succ)
+            neighbor.agents.push_back(a);
             continue;
-
-        // store the neighbor information
-        neighbor.old_paths.resize(neighbor.agents.size());
-        neighbor.old_sum_of_costs = 0;
-        for (int i = 0; i < (int)neighbor.agents.size(); i++)
+        }
+        path_table.insertPath(a, agents[a].path);
+        sum_of_costs += (int)agents[a].path.size() - 1;
+    }
+    if (neighbor.agents.empty())
+        return true;
+    neighbor.old_paths.clear();
+    neighbor.old_sum_of_costs = MAX_COST;
+    while (!runPP())
+    {
+        if (((fsec)(Time::now() - start_time)).count() >= time_limit)
+            return false;
+        if (neighbor.agents.size() < moving_agents.size()) // replan all moving agents, so that PP can order them freely
         {
-            if (replan_algo_name == "PP")
-                neighbor.old_paths[i] = agents[neighbor.agents[i]].path;
-            path_table.deletePath(neighbor.agents[i], agents[neighbor.agents[i]].path);
-            neighbor.old_sum_of_costs += agents[neighbor.agents[i]].path.size() - 1;
+            for (int a : moving_agents)
+            {
+                if (!std::binary_search(neighbor.agents.begin(), neighbor.agents.end(), a))
+                    path_table.deletePath(a, agents[a].path);
+            }
+            neighbor.agents = moving_agents;
+            sum_of_costs = 0;
         }
-        auto replan_start_time = Time::now();
-        if (replan_algo_name == "EECBS")
+    }
+    sum_of_costs += neighbor.sum_of_costs;
+    return true;
+}
+
+bool LNS::assignGoals()
+{
+    bool assigned = false;
+    list<int> failed_goals;
+    int goal;
+    for (const auto& agent : agents)
+    {
+        if (agent.path.size() > 1)
+            continue;
+        if (!readGoal(goal))
+            break;
+        if (assignGoal(agent.id, goal))
+            assigned = true;
+        else
+            failed_goals.push_back(goal);
+    }
+    pending_goals.splice(pending_goals.begin(), failed_goals); // retry them first in the next tick
+    return assigned;
+}
+
+// plans a path from the current location of the (idle) agent to its new goal, keeping the other paths fixed
+bool LNS::assignGoal(int agent, int goal)
+{
+    int curr = agents[agent].path.front().location;
+    if (goal == curr)
+    {
+        num_of_finished_tasks++;
+        return true;
+    }
+    agents[agent].path_planner->setGoalLocation(goal);
+    neighbor.agents.assign(1, agent);
+    neighbor.old_paths.resize(1);
+    neighbor.old_sum_of_costs = MAX_COST;
+    path_table.deletePath(agent, agents[agent].path);
+    neighbor.old_paths[0].swap(agents[agent].path);
+    if (runPP())
+    {
+        sum_of_costs += neighbor.sum_of_costs;
+        return true;
+    }
+    agents[agent].path_planner->setGoalLocation(curr); // runPP has restored the old path
+    return false;
+}
+
+bool LNS::readGoal(int& goal)
+{
+    if (!pending_goals.empty())
+    {
+        goal = pending_goals.front();
+        pending_goals.pop_front();
+        return true;
+    }
+    int row, col;
+    if (!(goal_input >> row >> col))
+    {
+        goal_input.clear(); // so that goals appended later are read in the next tick
+        return false;
+    }
+    if (row < 0 or row >= instance.num_of_rows or col < 0 or col >= instance.num_of_cols or
+        instance.isObstacle(instance.linearizeCoordinate(row, col)))
+    {
+        cerr << "Goal (" << row << "," << col << ") in " << goal_stream << " is not a free cell." << endl;
+        exit(-1);
+    }
+    goal = instance.linearizeCoordinate(row, col);
+    return true;
+}
+
+void LNS::runIteration()
+{
+    PROFILE_SCOPE("LNS iteration");
+    runtime =((fsec)(Time::now() - start_time)).count();
+    if(screen >= 1)
+        validateSolution();
+
+    auto removal_start = Time::now();
+    bool succ = false;
+
+    sampleDestroyHeuristicAndNeighborhoodSize(); // only sample the nb size
+
+    if (uniform_neighbor==0){ // use the specified nb_size
+        neighbor_size = specified_neighbor ;
+    }
+    else if (uniform_neighbor==1){ // sample from {2,4,8,16,32}
+        neighbor_size =getRandomFromSetExp(generator);
+    }
+    else if (uniform_neighbor==2){ // sample a random int from range 5 ~ 16
+        neighbor_size =getRandomFromRange(generator);
+    }
+
+    switch (destroy_strategy)
+    {
+
+        case RANDOMWALK:
+            succ = generateNeighborByRandomWalk();
+            if (not succ){
+                cout << "RANDOMWALK Failed to generate a neighbor" << endl;
+            }
+            break;
+        case INTERSECTION:
+            succ = generateNeighborByIntersection();
+            if (not succ){
+                cout << "INTERSECTION Failed to generate a neighbor" << endl;
+            }
+            break;
+        case RANDOMAGENTS:
+            neighbor.agents.resize(agents.size());
+            for (int i = 0; i < (int)agents.size(); i++)
+                neighbor.agents[i] = i;
+            if (neighbor.agents.size() > neighbor_size)
+            {
+                std::shuffle(neighbor.agents.begin(), neighbor.agents.end(), generator);
+                neighbor.agents.resize(neighbor_size);
+            }
+            assert(neighbor.agents.size() > 0);
+            succ = true;
+            if (not succ){
+                cout << "RANDOMAGENTS Failed to generate a neighbor" << endl;
+            }
+            break;
+        default:
+            cerr << "Wrong neighbor generation strategy" << endl;
+            exit(-1);
+    }
+    auto removal_time =  ((fsec)(Time::now() - removal_start)).count() ;
+    int searchSuccess = succ? 1 : 0;
+    if(!succ)
+    {
+        lns_runtime += removal_time; // otherwise the loop never ends once no neighbor can be generated
+        return;
+    }
+
+    const string& repair_algo_name = repair_algos.size() > 1 ?
+            repair_algos[sampleDestroyHeuristic(&repairBanditStats)] : repair_algos.front();
+
+    // store the neighbor information
+    // (the old paths are swapped out rather than copied, as PP and PIBT overwrite the paths of the agents)
+    neighbor.old_paths.resize(neighbor.agents.size());
+    neighbor.old_sum_of_costs = 0;
+    for (int i = 0; i < (int)neighbor.agents.size(); i++)
+    {
+        path_table.deletePath(neighbor.agents[i], agents[neighbor.agents[i]].path);
+        neighbor.old_sum_of_costs += agents[neighbor.agents[i]].path.size() - 1;
+        if (repair_algo_name != "EECBS" && repair_algo_name != "CBS")
+            neighbor.old_paths[i].swap(agents[neighbor.agents[i]].path);
+    }
+    auto replan_start_time = Time::now();
+    {
+        PROFILE_SCOPE("repair");
+        if (repair_algo_name == "EECBS")
             succ = runEECBS();
-        else if (replan_algo_name == "CBS")
+        else if (repair_algo_name == "CBS")
             succ = runCBS();
-        else if (replan_algo_name == "PP")
+        else if (repair_algo_name == "PP")
             succ = runPP();
+        else if (repair_algo_name == "PIBT")
+            succ = runPIBTRepair(false);
+        else if (repair_algo_name == "winPIBT")
+            succ = runPIBTRepair(true);
         else
         {
             cerr << "Wrong replanning strategy" << endl;
             exit(-1);
         }
-        auto replan_time = ((fsec)(Time::now() - replan_start_time)).count();
-        if (replan_time > replan_time_limit){
-            replan_time = replan_time_limit;
-        }
-        if (iteration_stats.size() <= 2000  or  iteration_stats.size() % log_step == 0 or replan_time > replan_time_limit){
-            cout << "lns_runtime : " << lns_runtime << " replan_time : " << replan_time << " neighbor_size  : " << neighbor_size << " group_size : " << neighbor.agents.size() << " removal_time : " << removal_time <<  endl;
-        }
-        
-        removal_start = Time::now();
-        const bool condition = neighbor.old_sum_of_costs > neighbor.sum_of_costs;
-        double value = (neighbor.old_sum_of_costs - neighbor.sum_of_costs);
-        if(neighbor.agents.size())
-        {
-            value /= neighbor.agents.size();
-        }
-        updateDestroyAndNeighborhoodWeights(value, condition);
-        removal_time +=  ((fsec)(Time::now() - removal_start)).count() ;
-
-        lns_runtime = lns_runtime + replan_time + removal_time;
-
-        runtime = ((fsec)(Time::now() - start_time)).count();
-        sum_of_costs += neighbor.sum_of_costs - neighbor.old_sum_of_costs;
-        
-        int sum_of_delay = 0;
-        for (int i = 0; i < agents.size(); i++){
-            sum_of_delay += agents[i].getNumOfDelays();
-        }
-        if (iteration_stats.size() <= 2000  or  iteration_stats.size() % log_step == 0 or replan_time > replan_time_limit){
-            cout << "Iteration " << iteration_stats.size() << ", "
-                << "group size = " << neighbor.agents.size() << ", "
-                << "solution cost = " << sum_of_costs << ", "
-                << "remaining time = " << time_limit - lns_runtime << ", sum_of_delay = " << sum_of_delay << endl;
-        }
-        iteration_stats.emplace_back(neighbor.agents.size(), sum_of_costs, runtime, replan_algo_name, 0, 0, searchSuccess);
     }
+    auto replan_time = ((fsec)(Time::now() - replan_start_time)).count();
+    if (replan_time > replan_time_limit){
+        replan_time = replan_time_limit;
+    }
+    if (iteration_stats.size() <= 2000  or  iteration_stats.size() % log_step == 0 or replan_time > replan_time_limit){
+        cout << "lns_runtime : " << lns_runtime << " replan_time : " << replan_time << " neighbor_size  : " << neighbor_size << " group_size : " << neighbor.agents.size() << " removal_time : " << removal_time <<  endl;
+    }
+    
+    removal_start = Time::now();
+    const bool condition = neighbor.old_sum_of_costs > neighbor.sum_of_costs;
+    double value = (neighbor.old_sum_of_costs - neighbor.sum_of_costs);
+    if(neighbor.agents.size())
+    {
+        value /= neighbor.agents.size();
+    }
+    updateDestroyAndNeighborhoodWeights(value, condition);
+    if (repair_algos.size() > 1)
+        updateDestroyWeights(&repairBanditStats, value, condition);
+    removal_time +=  ((fsec)(Time::now() - removal_start)).count() ;
 
+    lns_runtime = lns_runtime + replan_time + removal_time;
 
-    average_group_size = - iteration_stats.front().num_of_agents;
-    for (const auto& data : iteration_stats)
-        average_group_size += data.num_of_agents;
-    if (average_group_size > 0)
-        average_group_size /= (double)(iteration_stats.size() - 1);
-        
+    runtime = ((fsec)(Time::now() - start_time)).count();
+    sum_of_costs += neighbor.sum_of_costs - neighbor.old_sum_of_costs;
+    
     int sum_of_delay = 0;
     for (int i = 0; i < agents.size(); i++){
         sum_of_delay += agents[i].getNumOfDelays();
     }
-
-    cout << getSolverName() << ": Iterations = " << iteration_stats.size() << ", "
-         << "solution cost = " << sum_of_costs << ", "
-         << "initial solution cost = " << initial_sum_of_costs << ", "
-         << "lns_runtime = " << lns_runtime << ", "
-         << "group size = " << average_group_size << ", "
-         << "failed iterations = " << num_of_failures << ", sum_of_delay = " << sum_of_delay << endl;
-    return true;
+    if (iteration_stats.size() <= 2000  or  iteration_stats.size() % log_step == 0 or replan_time > replan_time_limit){
+        cout << "Iteration " << iteration_stats.size() << ", "
+            << "group size = " << neighbor.agents.size() << ", "
+            << "solution cost = " << sum_of_costs << ", "
+            << "remaining time = " << time_limit - lns_runtime << ", sum_of_delay = " << sum_of_delay << endl;
+    }
+    iteration_stats.emplace_back(neighbor.agents.size(), sum_of_costs, runtime, repair_algo_name, 0, 0, searchSuccess);
 }
 
 
@@ -318,7 +647,9 @@ bool LNS::getInitialSolution()
     neighbor.old_sum_of_costs = MAX_COST;
     neighbor.sum_of_costs = 0;
     bool succ = false;
-    if (init_algo_name == "EECBS")
+    if (!init_portfolio.empty())
+        succ = runPortfolio();
+    else if (init_algo_name == "EECBS")
         succ = runEECBS();
     else if (init_algo_name == "PP")
         succ = runPP();
@@ -358,6 +689,8 @@ bool LNS::runEECBS()
     }
 
     ECBS ecbs(search_engines, screen - 1, &path_table);
+    ecbs.setInterrupt(interrupt);
+    ecbs.setSeed(generator());
     ecbs.setPrioritizeConflicts(true);
     ecbs.setDisjointSplitting(false);
     ecbs.setBypass(true);
@@ -420,6 +753,8 @@ bool LNS::runCBS()
     }
 
     CBS cbs(search_engines, screen - 1, &path_table);
+    cbs.setInterrupt(interrupt);
+    cbs.setSeed(generator());
     cbs.setPrioritizeConflicts(true);
     cbs.setDisjointSplitting(false);
     cbs.setBypass(true);
@@ -469,7 +804,7 @@ bool LNS::runCBS()
 bool LNS::runPP()
 {
     auto shuffled_agents = neighbor.agents;
-    std::random_shuffle(shuffled_agents.begin(), shuffled_agents.end());
+    std::shuffle(shuffled_agents.begin(), shuffled_agents.end(), generator);
     if (screen >= 2) {
         for (auto id : shuffled_agents)
             cout << id << "(" << agents[id].path_planner->my_heuristic[agents[id].path_planner->start_location] <<
@@ -485,7 +820,7 @@ bool LNS::runPP()
         T = min(T, replan_time_limit);
     auto time = Time::now();
     ConstraintTable constraint_table(instance.num_of_cols, instance.map_size, &path_table);
-    while (p != shuffled_agents.end() && ((fsec)(Time::now() - time)).count() < replan_time_limit)
+    while (p != shuffled_agents.end() && ((fsec)(Time::now() - time)).count() < replan_time_limit && !isInterrupted())
     {
         int id = *p;
         if (screen >= 3)
@@ -522,7 +857,7 @@ bool LNS::runPP()
             for (int i = 0; i < (int)neighbor.agents.size(); i++)
             {
                 int a = *p2;
-                agents[a].path = neighbor.old_paths[i];
+                agents[a].path.swap(neighbor.old_paths[i]);
                 path_table.insertPath(agents[a].id, agents[a].path);
                 ++p2;
             }
@@ -531,59 +866,188 @@ bool LNS::runPP()
         return false;
     }
 }
+bool LNS::runPortfolio()
+{
+    // race one worker per portfolio entry; each owns copies of the agents and its own path table
+    vector<LNS*> workers;
+    workers.reserve(init_portfolio.size());
+    for (const auto& algo : init_portfolio)
+        workers.push_back(new LNS(*this, algo));
+    std::atomic<bool> stop(false);
+    std::mutex mtx;
+    std::condition_variable cv;
+    vector<bool> worker_succ(workers.size(), false);
+    int num_finished = 0;
+    bool found = false;
+    vector<std::thread> threads;
+    for (size_t i = 0; i < workers.size(); i++)
+    {
+        workers[i]->interrupt = &stop;
+        workers[i]->setSeed(seed + (int)i + 1);
+        threads.emplace_back([&, i]()
+        {
+            PROFILE_SCOPE("portfolio worker"); // the root of the profile of this thread
+            threadRandomEngine().seed(workers[i]->seed); // heap tie-breaking in this thread
+            bool succ = workers[i]->getInitialSolution();
+            std::lock_guard<std::mutex> lock(mtx);
+            worker_succ[i] = succ;
+            found = found || succ;
+            num_finished++;
+            cv.notify_all();
+        });
+    }
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        cv.wait(lock, [&]() { return found || num_finished == (int)workers.size(); });
+        if (portfolio_grace > 0) // give the slower workers a chance to return a cheaper solution
+            cv.wait_for(lock, std::chrono::duration<double>(portfolio_grace),
+                        [&]() { return num_finished == (int)workers.size(); });
+    }
+    stop = true;
+    for (auto& thread : threads)
+        thread.join();
+
+    int best = -1;
+    for (int i = 0; i < (int)workers.size(); i++)
+    {
+        if (worker_succ[i] && (best < 0 || workers[i]->neighbor.sum_of_costs < workers[best]->neighbor.sum_of_costs))
+            best = i;
+        sum_of_costs_lowerbound = max(sum_of_costs_lowerbound, workers[i]->sum_of_costs_lowerbound);
+        if (screen >= 1)
+            cout << "Portfolio worker " << init_portfolio[i] << ": " << (worker_succ[i] ? "succeeded" : "failed")
+                 << (worker_succ[i] ? ", sum of costs = " + std::to_string(workers[i]->neighbor.sum_of_costs) : "")
+                 << endl;
+    }
+    if (best >= 0) // accept the cheapest solution
+    {
+        for (size_t i = 0; i < agents.size(); i++)
+        {
+            agents[i].path = std::move(workers[best]->agents[i].path);
+            path_table.insertPath(agents[i].id, agents[i].path);
+        }
+        neighbor.sum_of_costs = workers[best]->neighbor.sum_of_costs;
+    }
+    for (auto worker : workers)
+        delete worker;
+    return best >= 0;
+}
 bool LNS::runPPS(){
     auto shuffled_agents = neighbor.agents;
-    std::random_shuffle(shuffled_agents.begin(), shuffled_agents.end());
+    std::shuffle(shuffled_agents.begin(), shuffled_agents.end(), generator);
 
     MAPF P = preparePIBTProblem(shuffled_agents);
     P.setTimestepLimit(pipp_option.timestepLimit);
 
     // seed for solver
-    auto* MT_S = new std::mt19937(0);
-    PPS solver(&P,MT_S);
+    std::mt19937 MT_S(generator());
+    PPS solver(&P,&MT_S);
     solver.setTimeLimit(time_limit);
+    solver.setInterrupt(interrupt);
     bool result = solver.solve();
     if (result)
-        updatePIBTResult(P.getA(),shuffled_agents);
+        result = updatePIBTResult(P.getA(),shuffled_agents);
     return result;
 }
 bool LNS::runPIBT(){
     auto shuffled_agents = neighbor.agents;
-     std::random_shuffle(shuffled_agents.begin(), shuffled_agents.end());
+     std::shuffle(shuffled_agents.begin(), shuffled_agents.end(), generator);
 
     MAPF P = preparePIBTProblem(shuffled_agents);
 
     // seed for solver
-    auto MT_S = new std::mt19937(0);
-    PIBT solver(&P,MT_S);
+    std::mt19937 MT_S(generator());
+    PIBT solver(&P,&MT_S);
     solver.setTimeLimit(time_limit);
+    solver.setInterrupt(interrupt);
     bool result = solver.solve();
     if (result)
-        updatePIBTResult(P.getA(),shuffled_agents);
+        result = updatePIBTResult(P.getA(),shuffled_agents);
     return result;
 }
 bool LNS::runWinPIBT(){
     auto shuffled_agents = neighbor.agents;
-    std::random_shuffle(shuffled_agents.begin(), shuffled_agents.end());
+    std::shuffle(shuffled_agents.begin(), shuffled_agents.end(), generator);
 
     MAPF P = preparePIBTProblem(shuffled_agents);
     P.setTimestepLimit(pipp_option.timestepLimit);
 
     // seed for solver
-    auto MT_S = new std::mt19937(0);
-    winPIBT solver(&P,pipp_option.windowSize,pipp_option.winPIBTSoft,MT_S);
+    std::mt19937 MT_S(generator());
+    winPIBT solver(&P,pipp_option.windowSize,pipp_option.winPIBTSoft,&MT_S);
     solver.setTimeLimit(time_limit);
+    solver.setInterrupt(interrupt);
     bool result = solver.solve();
     if (result)
-        updatePIBTResult(P.getA(),shuffled_agents);
+        result = updatePIBTResult(P.getA(),shuffled_agents);
     return result;
 }
+bool LNS::runPIBTRepair(bool windowed)
+{
+    auto shuffled_agents = neighbor.agents;
+    std::shuffle(shuffled_agents.begin(), shuffled_agents.end(), generator);
+
+    MAPF P = preparePIBTProblem(shuffled_agents);
+    // an agent arriving later than this makes the neighborhood more expensive anyway
+    int sum_of_distances = 0, max_distance = 0;
+    for (int a : neighbor.agents)
+    {
+        int d = agents[a].path_planner->my_heuristic[agents[a].path_planner->start_location];
+        sum_of_distances += d;
+        max_distance = max(max_distance, d);
+    }
+    P.setTimestepLimit(max(path_table.makespan, neighbor.old_sum_of_costs - sum_of_distances + max_distance));
+    // the agents outside the neighborhood stay in path_table and are avoided as moving obstacles
+    auto blocked = [this](int from, int to, int to_time) { return path_table.constrained(from, to, to_time); };
+
+    double T = replan_time_limit; // the LNS budget is checked by the caller, as for PP
+    std::mt19937 MT_S(generator());
+    bool succ;
+    if (windowed)
+    {
+        winPIBT solver(&P,pipp_option.windowSize,pipp_option.winPIBTSoft,&MT_S);
+        solver.setObstacles(blocked, path_table.makespan);
+        solver.setTimeLimit(T);
+        solver.setInterrupt(interrupt);
+        succ = solver.solve();
+    }
+    else
+    {
+        PIBT solver(&P,&MT_S);
+        solver.setObstacles(blocked, path_table.makespan);
+        solver.setTimeLimit(T);
+        solver.setInterrupt(interrupt);
+        succ = solver.solve();
+    }
+    succ = succ && updatePIBTResult(P.getA(), shuffled_agents);
+    if (succ && neighbor.sum_of_costs <= neighbor.old_sum_of_costs) // accept new paths
+        return true;
+
+    // stick to old paths
+    if (succ)
+    {
+        for (int a : neighbor.agents)
+            path_table.deletePath(agents[a].id, agents[a].path);
+    }
+    else
+        num_of_failures++;
+    for (int i = 0; i < (int)neighbor.agents.size(); i++)
+    {
+        int a = neighbor.agents[i];
+        agents[a].path.swap(neighbor.old_paths[i]);
+        path_table.insertPath(agents[a].id, agents[a].path);
+    }
+    neighbor.sum_of_costs = neighbor.old_sum_of_costs;
+    return false;
+}
 
 MAPF LNS::preparePIBTProblem(vector<int>& shuffled_agents){
 
-    // seed for problem and graph
-    auto MT_PG = new std::mt19937(0);
-    Graph* G = new SimpleGrid(instance.getMapFile());
+    // problem and graph draw from this solver's engine, which outlives the returned problem
+    if (pibt_graph == nullptr)
+        pibt_graph.reset(new InstanceGrid(instance, &generator));
+    else if (pibt_graph->getKnownPathsNum() > 16 * pibt_graph->getNodesNum())
+        pibt_graph->clearKnownPaths(); // the shortest paths stay valid across calls, but bound the memory
+    Graph* G = pibt_graph.get();
 
     std::vector<Task*> T;
     PIBT_Agents A;
@@ -591,7 +1055,7 @@ MAPF LNS::preparePIBTProblem(vector<int>& shuffled_agents){
     for (int i : shuffled_agents){
         assert(G->existNode(agents[i].path_planner->start_location));
         assert(G->existNode(agents[i].path_planner->goal_location));
-        auto a = new PIBT_Agent(G->getNode( agents[i].path_planner->start_location));
+        auto a = new PIBT_Agent(G->getNode( agents[i].path_planner->start_location), (int)A.size());
         A.push_back(a);
         Task* tau = new Task(G->getNode( agents[i].path_planner->goal_location));
 
@@ -602,11 +1066,22 @@ MAPF LNS::preparePIBTProblem(vector<int>& shuffled_agents){
         }
     }
 
-    return MAPF(G, A, T, MT_PG);
+    return MAPF(G, A, T, &generator);
+
+}
 
+bool LNS::isConsistentWithPathTable(const Path& path) const
+{
+    for (int t = 1; t < (int)path.size(); t++)
+    {
+        if (path_table.constrained(path[t - 1].location, path[t].location, t))
+            return false;
+    }
+    // no one may pass the goal after the agent stays there
+    return path_table.getHoldingTime(path.back().location, (int)path.size() - 1) <= (int)path.size() - 1;
 }
 
-void LNS::updatePIBTResult(const PIBT_Agents& A, vector<int>& shuffled_agents){
+bool LNS::updatePIBTResult(const PIBT_Agents& A, vector<int>& shuffled_agents){
     int soc = 0;
     for (int i=0; i<A.size();i++){
         int a_id = shuffled_agents[i];
@@ -637,11 +1112,18 @@ void LNS::updatePIBTResult(const PIBT_Agents& A, vector<int>& shuffled_agents){
             }
             cout<<endl;
         }
+        if (!isConsistentWithPathTable(agents[a_id].path)) // e.g., winPIBT waited in front of an obstacle
+        {
+            for (int j = 0; j < i; j++)
+                path_table.deletePath(agents[shuffled_agents[j]].id, agents[shuffled_agents[j]].path);
+            return false;
+        }
         path_table.insertPath(agents[a_id].id, agents[a_id].path);
         soc += (int)agents[a_id].path.size()-1;
     }
 
     neighbor.sum_of_costs =soc;
+    return true;
 }
 
 void LNS::chooseDestroyHeuristicbyALNS()
@@ -658,49 +1140,41 @@ void LNS::chooseDestroyHeuristicbyALNS()
 
 bool LNS::generateNeighborByIntersection()
 {
-    if (intersections.empty())
-    {
-        for (int i = 0; i < instance.map_size; i++)
-        {
-            if (!instance.isObstacle(i) && instance.getDegree(i) > 2)
-                intersections.push_back(i);
-        }
-    }
+    PROFILE_SCOPE("destroy");
+    const auto& intersections = instance.getIntersections();
     assert(!intersections.empty());
     set<int> neighbors_set;
-    auto pt = intersections.begin();
-    std::advance(pt, rand() % intersections.size());
-    int location = *pt;
-    path_table.get_agents(neighbors_set, neighbor_size, location);
+    int location = intersections[getRandomInt((int)intersections.size())];
+    path_table.get_agents(neighbors_set, neighbor_size, location, generator);
     if (neighbors_set.size() < neighbor_size)
-    {
-        set<int> closed;
-        closed.insert(location);
+    { // BFS over the intersection graph
+        if (intersection_visits.empty())
+            intersection_visits.resize(instance.map_size, 0);
+        num_of_intersection_searches++;
+        intersection_visits[location] = num_of_intersection_searches;
         std::queue<int> open;
         open.push(location);
         while (!open.empty() && (int) neighbors_set.size() < neighbor_size)
         {
             int curr = open.front();
             open.pop();
-            for (auto next : instance.getNeighbors(curr))
+            auto adjacent = instance.getAdjacentIntersections(curr);
+            for (auto next = adjacent.first; next != adjacent.second; ++next)
             {
-                if (closed.count(next) > 0)
+                if (intersection_visits[*next] == num_of_intersection_searches)
                     continue;
-                open.push(next);
-                closed.insert(next);
-                if (instance.getDegree(next) >= 3)
-                {
-                    path_table.get_agents(neighbors_set, neighbor_size, next);
-                    if ((int) neighbors_set.size() == neighbor_size)
-                        break;
-                }
+                open.push(*next);
+                intersection_visits[*next] = num_of_intersection_searches;
+                path_table.get_agents(neighbors_set, neighbor_size, *next, generator);
+                if ((int) neighbors_set.size() == neighbor_size)
+                    break;
             }
         }
     }
     neighbor.agents.assign(neighbors_set.begin(), neighbors_set.end());
     if (neighbor.agents.size() > neighbor_size)
     {
-        std::random_shuffle(neighbor.agents.begin(), neighbor.agents.end());
+        std::shuffle(neighbor.agents.begin(), neighbor.agents.end(), generator);
         neighbor.agents.resize(neighbor_size);
     }
     if (screen >= 2)
@@ -709,6 +1183,7 @@ bool LNS::generateNeighborByIntersection()
 }
 bool LNS::generateNeighborByRandomWalk()
 {
+    PROFILE_SCOPE("destroy");
     if (neighbor_size >= (int)agents.size())
     {
         neighbor.agents.resize(agents.size());
@@ -727,11 +1202,11 @@ bool LNS::generateNeighborByRandomWalk()
     int count = 0;
     while (neighbors_set.size() < neighbor_size && count < 10)
     {
-        int t = rand() % agents[a].path.size();
+        int t = getRandomInt((int)agents[a].path.size());
         randomWalk(a, agents[a].path[t].location, t, neighbors_set, neighbor_size, (int) agents[a].path.size() - 1);
         count++;
         // select the next agent randomly
-        int idx = rand() % neighbors_set.size();
+        int idx = getRandomInt((int)neighbors_set.size());
         int i = 0;
         for (auto n : neighbors_set)
         {
@@ -780,10 +1255,10 @@ int LNS::findMostDelayedAgent()
     return a;
 }
 
-int LNS::findRandomAgent() const
+int LNS::findRandomAgent()
 {
     int a = 0;
-    int pt = rand() % (sum_of_costs - sum_of_distances) + 1;
+    int pt = getRandomInt(sum_of_costs - sum_of_distances) + 1;
     int sum = 0;
     for (; a < (int) agents.size(); a++)
     {
@@ -806,7 +1281,7 @@ void LNS::randomWalk(int agent_id, int start_location, int start_timestep,
         next_locs.push_back(loc);
         while (!next_locs.empty())
         {
-            int step = rand() % next_locs.size();
+            int step = getRandomInt((int)next_locs.size());
             auto it = next_locs.begin();
             advance(it, step);
             int next_h_val = agents[agent_id].path_planner->my_heuristic[*it];
@@ -863,7 +1338,7 @@ void LNS::validateSolution() const
             const auto & a1 = a1_.path.size() <= a2_.path.size()? a1_ : a2_;
             const auto & a2 = a1_.path.size() <= a2_.path.size()? a2_ : a1_;
             int t = 1;
-            for (; t < (int) a1.path.size(); t++)
+            for (; t < (int) a1.path.size() and t <= window; t++)
             {
                 if (a1.path[t].location == a2.path[t].location) // vertex conflict
                 {
@@ -881,7 +1356,7 @@ void LNS::validateSolution() const
                 }
             }
             int target = a1.path.back().location;
-            for (; t < (int) a2.path.size(); t++)
+            for (t = (int) a1.path.size(); t < (int) a2.path.size(); t++)
             {
                 if (a2.path[t].location == target)  // target conflict
                 {
@@ -1002,6 +1477,13 @@ void LNS::writePathsToFile(const string & file_name) const
     for (const auto &agent : agents)
     {
         output << "Agent " << agent.id << ":";
+        if (!executed_paths.empty()) // lifelong mode: the committed prefix, followed by the remaining plan
+        {
+            const auto& executed = executed_paths[agent.id];
+            for (auto state = executed.begin(); state + 1 != executed.end(); ++state)
+                output << "(" << instance.getRowCoordinate(state->location) << "," <<
+                                instance.getColCoordinate(state->location) << ")->";
+        }
         for (const auto &state : agent.path)
             output << "(" << instance.getRowCoordinate(state.location) << "," <<
                             instance.getColCoordinate(state.location) << ")->";
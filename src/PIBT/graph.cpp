@@ -29,21 +29,30 @@ void Graph::init() {
 Graph::~Graph() {
   for (auto v : nodes) delete v;
   nodes.clear();
+  clearKnownPaths();
+}
+
+void Graph::clearKnownPaths() {
   for (auto p : knownPaths) delete p.second;
   knownPaths.clear();
 }
 
+void Graph::buildNodeTable() {
+  int maxId = -1;
+  for (auto v : nodes) maxId = std::max(maxId, v->getId());
+  nodeTable.assign(maxId + 1, nullptr);
+  for (auto v : nodes) nodeTable[v->getId()] = v;
+}
+
 Node* Graph::getNode(int id) {
-  auto itr = std::find_if(nodes.begin(), nodes.end(),
-                          [id](Node* v){ return v->getId() == id; });
   // error check
-  if (itr == nodes.end()) {
+  if (!existNode(id)) {
     std::cout << "error@Graph::getNode, "
               << "node index is over, " << id << "\n";
     std::exit(1);
   }
 
-  return *itr;
+  return nodeTable[id];
 }
 
 Node* Graph::getNode(int x, int y) {
@@ -56,9 +65,7 @@ Node* Graph::getNode(int x, int y) {
 }
 
 bool Graph::existNode(int id) {
-  auto itr = std::find_if(nodes.begin(), nodes.end(),
-                          [id](Node* v){ return v->getId() == id; });
-  return itr != nodes.end();
+  return 0 <= id && id < nodeTable.size() && nodeTable[id] != nullptr;
 }
 
 int Graph::getNodeIndex(Node* v) {
@@ -104,6 +111,7 @@ Nodes Graph::getPath(Node* _s, Node* _g,
   std::unordered_map<int, boost::heap::fibonacci_heap<Fib_AN>::handle_type> SEARCHED;
   std::unordered_set<int> CLOSE;
   AN* n = new AN { _s, 0, dist(_s, _g), nullptr };
+  std::vector<AN*> allocated = { n };  // freed once the path is extracted
   auto handle = OPEN.push(Fib_AN(n));
   SEARCHED.emplace(n->v->getId(), handle);
 
@@ -134,6 +142,7 @@ Nodes Graph::getPath(Node* _s, Node* _g,
       if (valid) {
         for (int i = 1; i < kPath.size(); ++i) {
           n = new AN { kPath[i], 0, 0, n };
+          allocated.push_back(n);
         }
         invalid = false;
         break;
@@ -166,6 +175,7 @@ Nodes Graph::getPath(Node* _s, Node* _g,
       auto itrS = SEARCHED.find(m->getId());
       if (itrS == SEARCHED.end()) {  // new node
         AN* l = new AN { m, n->g + 1, f, n };
+        allocated.push_back(l);
         auto handle = OPEN.push(Fib_AN(l));
         SEARCHED.emplace(l->v->getId(), handle);
       } else {
@@ -181,17 +191,18 @@ Nodes Graph::getPath(Node* _s, Node* _g,
     }
   }
 
-  if (invalid) return path;
-
-  // back tracking
-  while (n != nullptr) {
-    path.push_back(n->v);
-    n = n->p;
+  if (!invalid) {
+    // back tracking
+    while (n != nullptr) {
+      path.push_back(n->v);
+      n = n->p;
+    }
+    std::reverse(path.begin(), path.end());
   }
-  std::reverse(path.begin(), path.end());
+  for (auto l : allocated) delete l;
 
   // register path
-  if (regFlg && !prohibited) registerPath(path);
+  if (!invalid && regFlg && !prohibited) registerPath(path);
 
   return path;
 }
@@ -217,8 +228,8 @@ void Graph::registerPath(const Nodes &path) {
     v1 = tmp[0];
     v2 = tmp[tmp.size() - 1];
     key = getKey(v1, v2);
-    KnownPath* knownPath = new KnownPath { v1, v2, tmp };
-    knownPaths.emplace(key, knownPath);
+    if (knownPaths.find(key) == knownPaths.end())
+      knownPaths.emplace(key, new KnownPath { v1, v2, tmp });
     tmp.erase(tmp.begin());
   } while (tmp.size() > 2);
 }
@@ -0,0 +1,43 @@
+/*
+ * instancegrid.cpp
+ *
+ * Purpose: grid built from an already loaded instance
+ */
+
+#include "instancegrid.h"
+
+
+InstanceGrid::InstanceGrid(const Instance& instance, std::mt19937* _MT)
+  : Grid(_MT), filename(instance.getMapFile()), instance(instance)
+{
+  setSize(instance.num_of_cols, instance.num_of_rows);
+
+  // node ids are the locations of the instance
+  for (int id = 0; id < instance.map_size; ++id) {
+    if (instance.isObstacle(id)) continue;
+    Node* v = new Node(id, nodes.size());
+    v->setPos(instance.getRowCoordinate(id), instance.getColCoordinate(id));
+    nodes.push_back(v);
+  }
+  buildNodeTable();
+
+  // same neighbor order as SimpleGrid: up, left, right, down
+  for (auto v : nodes) {
+    int id = v->getId();
+    Nodes neighbor;
+    if (existNode(id - w)) neighbor.push_back(getNode(id - w));
+    if (id % w > 0 && existNode(id - 1)) neighbor.push_back(getNode(id - 1));
+    if (id % w < w - 1 && existNode(id + 1)) neighbor.push_back(getNode(id + 1));
+    if (existNode(id + w)) neighbor.push_back(getNode(id + w));
+    v->setNeighbor(neighbor);
+  }
+
+  starts = nodes;
+  goals = nodes;
+}
+
+std::string InstanceGrid::logStr() {
+  std::string str = Grid::logStr();
+  str += "[graph] filename:" + filename + "\n";
+  return str;
+}
@@ -7,9 +7,6 @@
 
 #include "node.h"
 
-int Node::cntIndex = 0;
-
-Node::Node(int _id) : id(_id), index(cntIndex) {
-  ++cntIndex;
+Node::Node(int _id, int _index) : id(_id), index(_index) {
   pos = Vec2f(0, 0);
 }
@@ -45,17 +45,17 @@ void PIBT::init() {
 bool PIBT::solve() {
   solveStart();
 
-  while (!P->isSolved()) {
+  while (!isFinished()) {
     allocate();
     update();
     P->update();
-      if(time_limit&&((fsec)(std::chrono::system_clock::now()-startT)).count()>time_limit){
+      if(stuck||overTimestepLimit()||isInterrupted()||(time_limit&&((fsec)(std::chrono::system_clock::now()-startT)).count()>time_limit)){
           break;
       }
   }
 
   solveEnd();
-  return P->isSolved();
+  return !stuck && isFinished();
 }
 
 void PIBT::allocate() {
@@ -209,15 +209,18 @@ bool PIBT::priorityInheritance(PIBT_Agent* a,
 
   // failed
   a->setNode(a->getNode());
+  if (isBlocked(a->getNode(), a->getNode(), P->getTimestep() + 1)) stuck = true;
   return false;
 }
 
 Nodes PIBT::createCandidates(PIBT_Agent* a, Nodes CLOSE_NODE) {
   Nodes C;
-  for (auto v : G->neighbor(a->getNode())) {
-    if (!inArray(v, CLOSE_NODE)) C.push_back(v);
+  Node* v = a->getNode();
+  int t = P->getTimestep() + 1;
+  for (auto u : G->neighbor(v)) {
+    if (!inArray(u, CLOSE_NODE) && !isBlocked(v, u, t)) C.push_back(u);
   }
-  if (!inArray(a->getNode(), CLOSE_NODE)) C.push_back(a->getNode());
+  if (!inArray(v, CLOSE_NODE) && !isBlocked(v, v, t)) C.push_back(v);
   return C;
 }
 
@@ -252,10 +255,11 @@ Node* PIBT::chooseNode(PIBT_Agent* a, Nodes C) {
 
   // fast implementation
   Nodes p = G->getPath(a->getNode(), g);
-  if (p.size() > 1 && inArray(p[1], C)) return p[1];
+  if (p.size() > 1 && inArray(p[1], C) && !isTrap(p[1])) return p[1];
 
   for (auto v : C) {
     cost = pathDist(v, g);
+    if (isTrap(v)) cost += 1000;
     if (cost < minCost) {
       minCost = cost;
       cs.clear();
@@ -278,6 +282,11 @@ Node* PIBT::chooseNode(PIBT_Agent* a, Nodes C) {
   return cs[0];
 }
 
+bool PIBT::isTrap(Node* v) {
+  // an obstacle enters v right after, so the agent could not wait there
+  return isBlocked(v, v, P->getTimestep() + 2);
+}
+
 void PIBT::updateC(Nodes& C, Node* target, Nodes CLOSE_NODE) {
   for (auto v : CLOSE_NODE) {
     auto itr2 = std::find_if(C.begin(), C.end(),
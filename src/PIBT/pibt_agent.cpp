@@ -8,18 +8,24 @@
 #include "pibt_agent.h"
 #include "util.h"
 
-int PIBT_Agent::cntId = 0;
+std::atomic<int> PIBT_Agent::cntId(0);
 
-PIBT_Agent::PIBT_Agent() : id(cntId) {
-    ++cntId;
+PIBT_Agent::PIBT_Agent() : id(cntId++) {
     g = nullptr;
     tau = nullptr;
     updated = false;
     beforeNode = nullptr;
 }
 
-PIBT_Agent::PIBT_Agent(Node* _v) : id(cntId) {
-    ++cntId;
+PIBT_Agent::PIBT_Agent(Node* _v) : id(cntId++) {
+    g = nullptr;
+    tau = nullptr;
+    v = nullptr;
+    setNode(_v);
+    updated = false;
+}
+
+PIBT_Agent::PIBT_Agent(Node* _v, int _id) : id(_id) {
     g = nullptr;
     tau = nullptr;
     v = nullptr;
@@ -12,7 +12,7 @@
 #include "pps.h"
 #include "util.h"
 
-int PPS::s_uuid = 0;
+std::atomic<int> PPS::s_uuid(0);
 
 PPS::PPS(Problem* _P) : Solver(_P) {
   init();
@@ -52,7 +52,7 @@ bool PPS::solve() {
       return false;
     }
     P->update();
-      if(time_limit&&((fsec)(std::chrono::system_clock::now()-startT)).count()>time_limit){
+      if(isInterrupted()||(time_limit&&((fsec)(std::chrono::system_clock::now()-startT)).count()>time_limit)){
           break;
       }
   }
@@ -619,7 +619,7 @@ void PPS::SETUP_SWAP(PIBT_Agent* c, PIBT_Agent* a) {
     agents = {a, c};
   }
 
-  S* s = new S { s_uuid,
+  S* s = new S { s_uuid++,
                  agents,  // [near (high), far (low)]
                  a->getNode(),  // [low] original pos
                  sorted_esv,
@@ -629,7 +629,6 @@ void PPS::SETUP_SWAP(PIBT_Agent* c, PIBT_Agent* a) {
                  nullptr,  // evacL
                  {},       // area
                  SWAPPHASE::GO_TARGET };
-  ++s_uuid;
 
   pusherToSwaper.push_back(c);
   pusherToSwaper.push_back(a);
@@ -939,6 +938,7 @@ Nodes PPS::CLOSEST_EMPTY_VERTICLES(PIBT_Agent* c) {
       }
     }
   }
+  for (auto& entry : table) delete entry.second;
 
   return Y;
 }
@@ -104,7 +104,7 @@ void SimpleGrid::createNodes() {
         s = line[i];
         id = j * w + i;
         if (s == 'T' or s == '@') continue;
-        Node* v = new Node(id);
+        Node* v = new Node(id, nodes.size());
         v->setPos(j, i);
         nodes.push_back(v);
       }
@@ -121,6 +121,7 @@ void SimpleGrid::createNodes() {
               << "height is invalid, shoudl be " << h <<  "\n";
     std::exit(1);
   }
+  buildNodeTable();
 }
 
 void SimpleGrid::createEdges() {
@@ -25,8 +25,22 @@ Solver::~Solver() {}
 void Solver::init() {
   G = P->getG();
   A = P->getA();
-  int nodeNum = G->getNodesNum();
-  dists = Eigen::MatrixXi::Zero(nodeNum, nodeNum);
+}
+
+std::vector<int>& Solver::distsTo(int g_index) {
+  auto itr = dists.find(g_index);
+  if (itr == dists.end())
+    itr = dists.emplace(g_index, std::vector<int>(G->getNodesNum(), 0)).first;
+  return itr->second;
+}
+
+bool Solver::isFinished() {
+  // agents at their goals must also outlast the obstacles
+  return P->isSolved() && P->getTimestep() >= obstacleHorizon;
+}
+
+bool Solver::overTimestepLimit() {
+  return P->getTimestepLimit() > 0 && P->getTimestep() >= P->getTimestepLimit();
 }
 
 void Solver::solveStart() {
@@ -83,26 +97,25 @@ void Solver::solveEnd() {
 
 void Solver::WarshallFloyd() {
   int nodeNum = G->getNodesNum();
-  Nodes neighbor;
   int INF = 100000;
-  dists = Eigen::MatrixXi::Ones(nodeNum, nodeNum) * INF;
 
-  // initialize weight
+  // all pairs, by a backward breadth-first search from every goal
+  std::vector<Nodes> predecessors(nodeNum);
   for (int i = 0; i < nodeNum; ++i) {
-    neighbor = G->neighbor(G->getNodeFromIndex(i));
-    for (auto v : neighbor) {
-      dists(i, v->getIndex()) = 1;
+    for (auto v : G->neighbor(G->getNodeFromIndex(i))) {
+      predecessors[v->getIndex()].push_back(G->getNodeFromIndex(i));
     }
-    dists(i, i) = 0;
   }
-
-  // main loop
-  for (int k = 0; k < nodeNum; ++k) {
-    for (int i = 0; i < nodeNum; ++i) {
-      for (int j = 0; j < nodeNum; ++j) {
-        if (dists(i, j) > dists(i, k) + dists(k, j)) {
-          dists(i, j) = dists(i, k) + dists(k, j);
-        }
+  for (int j = 0; j < nodeNum; ++j) {
+    auto& column = distsTo(j);
+    std::fill(column.begin(), column.end(), INF);
+    column[j] = 0;
+    std::vector<int> queue = { j };
+    for (int k = 0; k < queue.size(); ++k) {
+      for (auto u : predecessors[queue[k]]) {
+        if (column[u->getIndex()] != INF) continue;
+        column[u->getIndex()] = column[queue[k]] + 1;
+        queue.push_back(u->getIndex());
       }
     }
   }
@@ -132,7 +145,8 @@ int Solver::pathDist(Node* s, Node* g) {
   // has already explored?
   int s_index = G->getNodeIndex(s);
   int g_index = G->getNodeIndex(g);
-  int dist = dists(s_index, g_index);
+  auto& dists_to_g = distsTo(g_index);
+  int dist = dists_to_g[s_index];
   if (dist != 0) return dist;
 
   // new
@@ -145,11 +159,14 @@ int Solver::pathDist(Node* s, Node* g) {
   cost = dist;
   for (auto v : path) {
     index = G->getNodeIndex(v);
-    d = dists(index, g_index);
+    d = dists_to_g[index];
     if ((index != g_index) && (d == 0)) {
-      dists(index, g_index) = cost;
-      // if not directed graph
-      if (!directed) dists(g_index, index) = cost;
+      dists_to_g[index] = cost;
+      // if not directed graph, fill the reverse direction for the goals queried so far
+      if (!directed) {
+        auto itr = dists.find(index);
+        if (itr != dists.end()) itr->second[g_index] = cost;
+      }
       --cost;
     } else if (d == cost) {
       break;
@@ -9,37 +9,32 @@
 #include "util.h"
 
 
-int Task::cntId = 0;
+std::atomic<int> Task::cntId(0);
 
 
-Task::Task() : id(cntId) {
-  ++cntId;
+Task::Task() : id(cntId++) {
   startTime = 0;
   endTime = 0;
 }
 
-Task::Task(Node* v) : id(cntId) {
-  ++cntId;
+Task::Task(Node* v) : id(cntId++) {
   startTime = 0;
   endTime = 0;
   G_OPEN.push_back(v);
 }
 
-Task::Task(int t) : id(cntId) {  // for mapd
-  ++cntId;
+Task::Task(int t) : id(cntId++) {  // for mapd
   startTime = t;
   endTime = 0;
 }
 
-Task::Task(Node* v, int t) : id(cntId) {
-  ++cntId;
+Task::Task(Node* v, int t) : id(cntId++) {
   startTime = t;
   endTime = 0;
   G_OPEN.push_back(v);
 }
 
-Task::Task(std::vector<Node*> nodes) : id(cntId) {
-  ++cntId;
+Task::Task(std::vector<Node*> nodes) : id(cntId++) {
   for (auto v : nodes) G_OPEN.push_back(v);
 }
 
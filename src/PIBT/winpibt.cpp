@@ -45,7 +45,7 @@ bool winPIBT::solve() {
   int t_sup = 0;
   int i, _w;
 
-  while (!P->isSolved()) {
+  while (!isFinished()) {
     allocate();
     updatePriority();
     std::vector<int> U(A.size());
@@ -82,7 +82,7 @@ bool winPIBT::solve() {
     for (int i = 0; i < A.size(); ++i) A[i]->setNode(PATHS[i][t+1]);
 
     P->update();
-    if(time_limit&&((fsec)(std::chrono::system_clock::now()-startT)).count()>time_limit){
+    if(overTimestepLimit()||isInterrupted()||(time_limit&&((fsec)(std::chrono::system_clock::now()-startT)).count()>time_limit)){
       break;
     }
 
@@ -90,7 +90,7 @@ bool winPIBT::solve() {
   }
 
   solveEnd();
-  return P->isSolved();
+  return isFinished();
 }
 
 void winPIBT::allocate() {
@@ -279,6 +279,7 @@ Nodes winPIBT::getPath(PIBT_Agent* a, Node* _g, int t1, int t2) {
                      boost::heap::fibonacci_heap<Fib_AN>::handle_type> SEARCHED;
   std::unordered_set<std::string> CLOSE;  // key
   AN* n = new AN { _s, t1, pathDist(_s, _g), nullptr };
+  std::vector<AN*> allocated = { n };  // freed once the path is extracted
   auto handle = OPEN.push(Fib_AN(n));
   key = getKey(n);
   SEARCHED.emplace(key, handle);
@@ -299,7 +300,10 @@ Nodes winPIBT::getPath(PIBT_Agent* a, Node* _g, int t1, int t2) {
     while (n->g + tmpPath.size() - 1 > t2) tmpPath.pop_back();
     if (checkValidPath(id, tmpPath, n->g, t2)) {
       tmpPath.erase(tmpPath.begin());
-      for (auto v : tmpPath) n = new AN { v, n->g + 1, 0, n };
+      for (auto v : tmpPath) {
+        n = new AN { v, n->g + 1, 0, n };
+        allocated.push_back(n);
+      }
       invalid = false;
       break;
     }
@@ -326,6 +330,7 @@ Nodes winPIBT::getPath(PIBT_Agent* a, Node* _g, int t1, int t2) {
       auto itrS = SEARCHED.find(key);
       if (itrS == SEARCHED.end()) {  // new node
         AN* l = new AN { m, g, f, n };
+        allocated.push_back(l);
         auto handle = OPEN.push(Fib_AN(l));
         SEARCHED.emplace(key, handle);
       } else {
@@ -349,6 +354,7 @@ Nodes winPIBT::getPath(PIBT_Agent* a, Node* _g, int t1, int t2) {
     }
     std::reverse(path.begin(), path.end());
   }
+  for (auto l : allocated) delete l;
 
   return path;
 }
@@ -360,6 +366,7 @@ bool winPIBT::checkValidPath(int id, Nodes &path, int t1, int t2) {
   for (int j = 1; j < path.size(); ++j) {
     v1 = path[j-1];
     v2 = path[j];
+    if (isBlocked(v1, v2, j + t1)) return false;
     for (int i = 0; i < A.size(); ++i) {
       if (id == i) continue;
 
@@ -4,12 +4,22 @@ void PathTable::insertPath(int agent_id, const Path& path)
 {
     if (path.empty())
         return;
-    for (int t = 0; t < (int)path.size(); t++)
+    int t_max = (int)min(path.size(), (size_t)window + 1);
+    for (int t = 0; t < t_max; t++)
     {
         if (table[path[t].location].size() <= t)
             table[path[t].location].resize(t + 1, NO_AGENT);
         table[path[t].location][t] = agent_id;
     }
+    if (t_max < (int)path.size() and late_visits.empty())
+        late_visits.resize(table.size());
+    for (int t = t_max; t < (int)path.size(); t++)
+    {
+        auto& visits = late_visits[path[t].location];
+        if ((int)visits.size() <= t - t_max)
+            visits.resize(t - t_max + 1, 0);
+        visits[t - t_max]++;
+    }
     assert(goals[path.back().location] == MAX_TIMESTEP);
     goals[path.back().location] = (int) path.size() - 1;
     makespan = max(makespan, (int) path.size() - 1);
@@ -19,11 +29,20 @@ void PathTable::deletePath(int agent_id, const Path& path)
 {
     if (path.empty())
         return;
-    for (int t = 0; t < (int)path.size(); t++)
+    int t_max = (int)min(path.size(), (size_t)window + 1);
+    for (int t = 0; t < t_max; t++)
     {
         assert(table[path[t].location].size() > t && table[path[t].location][t] == agent_id);
         table[path[t].location][t] = NO_AGENT;
     }
+    for (int t = t_max; t < (int)path.size(); t++)
+    {
+        auto& visits = late_visits[path[t].location];
+        assert((int)visits.size() > t - t_max && visits[t - t_max] > 0);
+        visits[t - t_max]--;
+        while (!visits.empty() and visits.back() == 0)
+            visits.pop_back();
+    }
     goals[path.back().location] = MAX_TIMESTEP;
     if (makespan == (int) path.size() - 1) // re-compute makespan
     {
@@ -43,7 +62,7 @@ bool PathTable::constrained(int from, int to, int to_time) const
     {
         if (table[to].size() > to_time && table[to][to_time] != NO_AGENT)
             return true;  // vertex conflict with agent table[to][to_time]
-        else if (table[to].size() >= to_time && table[from].size() > to_time && !table[to].empty() &&
+        else if (to_time > 0 && table[to].size() >= to_time && table[from].size() > to_time && !table[to].empty() &&
                  table[to][to_time - 1] != NO_AGENT && table[from][to_time] == table[to][to_time - 1])
             return true;  // edge conflict with agent table[to][to_time - 1]
     }
@@ -77,7 +96,7 @@ void PathTable::get_agents(set<int>& conflicting_agents, int loc) const
     }
 }
 
-void PathTable::get_agents(set<int>& conflicting_agents, int neighbor_size, int loc) const
+void PathTable::get_agents(set<int>& conflicting_agents, int neighbor_size, int loc, std::mt19937& rng) const
 {
     if (loc < 0 || table[loc].empty())
         return;
@@ -86,7 +105,7 @@ void PathTable::get_agents(set<int>& conflicting_agents, int neighbor_size, int
         t_max--;
     if (t_max == 0)
         return;
-    int t0 = rand() % t_max;
+    int t0 = (int)(rng() % t_max);
     if (table[loc][t0] != NO_AGENT)
         conflicting_agents.insert(table[loc][t0]);
     int delta = 1;
@@ -111,6 +130,8 @@ void PathTable::get_agents(set<int>& conflicting_agents, int neighbor_size, int
 // get the holding time after the earliest_timestep for a location
 int PathTable::getHoldingTime(int location, int earliest_timestep = 0) const
 {
+    if (!late_visits.empty() and !late_visits[location].empty()) // the last visit is after the window
+        return max(earliest_timestep, window + 1 + (int)late_visits[location].size());
     if (table.empty() or (int) table[location].size() <= earliest_timestep)
         return earliest_timestep;
     int rst = (int) table[location].size();
@@ -149,7 +170,8 @@ void PathTableWC::deletePath(int agent_id)
         assert(table[path[t].location].size() > t &&
                std::find (table[path[t].location][t].begin(), table[path[t].location][t].end(), agent_id)
                != table[path[t].location][t].end());
-        table[path[t].location][t].remove(agent_id);
+        auto& occupants = table[path[t].location][t];
+        occupants.erase(std::find(occupants.begin(), occupants.end(), agent_id));
     }
     goals[path.back().location] = MAX_TIMESTEP;
     if (makespan == (int) path.size() - 1) // re-compute makespan
@@ -179,7 +201,7 @@ int PathTableWC::getFutureNumOfCollisions(int loc, int time) const
 int PathTableWC::getNumOfCollisions(int from, int to, int to_time) const
 {
     int rst = 0;
-    if (!table.empty())
+    if (!table.empty() and to_time <= window)
     {
         if ((int)table[to].size() > to_time)
             rst += (int)table[to][to_time].size();  // vertex conflict
@@ -204,7 +226,7 @@ int PathTableWC::getNumOfCollisions(int from, int to, int to_time) const
 }
 bool PathTableWC::hasCollisions(int from, int to, int to_time) const
 {
-    if (!table.empty())
+    if (!table.empty() and to_time <= window)
     {
         if ((int)table[to].size() > to_time and !table[to][to_time].empty())
             return true; // vertex conflict
@@ -229,7 +251,7 @@ bool PathTableWC::hasCollisions(int from, int to, int to_time) const
 }
 bool PathTableWC::hasEdgeCollisions(int from, int to, int to_time) const
 {
-    if (!table.empty() && from != to && table[to].size() >= to_time && table[from].size() > to_time)
+    if (!table.empty() && to_time <= window && from != to && table[to].size() >= to_time && table[from].size() > to_time)
     {
         for (auto a1 : table[to][to_time - 1])
         {
@@ -0,0 +1,120 @@
+#include "Profiler.h"
+#include <cstring>
+#include <mutex>
+#include <nlohmann/json.hpp>
+
+bool Profiler::enabled = false;
+
+// the trees of all threads, kept after the threads exit
+static std::mutex roots_mutex;
+static vector<std::unique_ptr<Profiler::Scope>> roots;
+
+// scope names are string literals, so they are compared by address first
+static bool sameName(const char* name1, const char* name2)
+{
+	return name1 == name2 || strcmp(name1, name2) == 0;
+}
+
+Profiler::Scope* Profiler::Scope::getChild(const char* child_name)
+{
+	for (auto& child : children)
+	{
+		if (sameName(child->name, child_name))
+			return child.get();
+	}
+	children.emplace_back(new Scope(child_name, this));
+	return children.back().get();
+}
+
+void Profiler::Scope::count(const char* counter_name, uint64_t n)
+{
+	for (auto& counter : counters)
+	{
+		if (sameName(counter.first, counter_name))
+		{
+			counter.second += n;
+			return;
+		}
+	}
+	counters.emplace_back(counter_name, n);
+}
+
+void Profiler::Scope::merge(const Scope& other)
+{
+	seconds += other.seconds;
+	calls += other.calls;
+	for (const auto& counter : other.counters)
+		count(counter.first, counter.second);
+	for (const auto& child : other.children)
+		getChild(child->name)->merge(*child);
+}
+
+Profiler::Scope*& Profiler::current()
+{
+	thread_local Scope* scope = nullptr;
+	if (scope == nullptr)
+	{
+		std::lock_guard<std::mutex> lock(roots_mutex);
+		roots.emplace_back(new Scope("run", nullptr));
+		scope = roots.back().get();
+	}
+	return scope;
+}
+
+Profiler::Scope* Profiler::enter(const char* name)
+{
+	auto& scope = current();
+	scope = scope->getChild(name);
+	return scope;
+}
+
+void Profiler::leave(Scope* scope, double seconds)
+{
+	scope->seconds += seconds;
+	scope->calls++;
+	current() = scope->parent;
+}
+
+void Profiler::count(const char* name, uint64_t n)
+{
+	current()->count(name, n);
+}
+
+static nlohmann::json toJson(const Profiler::Scope& scope)
+{
+	nlohmann::json rst = {{"name", scope.name}, {"seconds", scope.seconds}, {"calls", scope.calls}};
+	double children_seconds = 0;
+	for (const auto& child : scope.children)
+	{
+		rst["children"].push_back(toJson(*child));
+		children_seconds += child->seconds;
+	}
+	rst["self_seconds"] = max(scope.seconds - children_seconds, 0.0);
+	for (const auto& counter : scope.counters)
+		rst["counters"][counter.first] = counter.second;
+	return rst;
+}
+
+void Profiler::write(const string& file_name)
+{
+	Scope merged("run", nullptr);
+	int num_of_threads;
+	{
+		std::lock_guard<std::mutex> lock(roots_mutex);
+		for (const auto& root : roots)
+			merged.merge(*root);
+		num_of_threads = (int)roots.size();
+	}
+	// the root is not timed itself, so it is the time spent in the top-level scopes of all threads
+	for (const auto& child : merged.children)
+		merged.seconds += child->seconds;
+	auto profile = toJson(merged);
+	profile["threads"] = num_of_threads;
+	ofstream output(file_name);
+	if (!output.is_open())
+	{
+		cerr << "Failed to write the profile to " << file_name << endl;
+		return;
+	}
+	output << profile.dump(2) << endl;
+}
@@ -156,6 +156,16 @@ void ReservationTable::updateSIT(int location)
             }
             if (constraint_table.path_table_for_CT->goals[location] < MAX_TIMESTEP) // target conflict
                 insert2SIT(location, constraint_table.path_table_for_CT->goals[location], MAX_TIMESTEP + 1);
+            const auto& late_visits = constraint_table.path_table_for_CT->late_visits;
+            if (location == goal_location and !late_visits.empty()) // so that the agent can arrive after the visits
+            {
+                int t_min = constraint_table.path_table_for_CT->window + 1;
+                for (int i = 0; i < (int)late_visits[location].size(); i++)
+                {
+                    if (late_visits[location][i] > 0)
+                        insert2SIT(location, t_min + i, t_min + i + 1);
+                }
+            }
         }
         else // edge conflict
         {
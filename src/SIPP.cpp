@@ -1,4 +1,7 @@
 #include "SIPP.h"
+#include "Profiler.h"
+
+thread_local vector<int> SIPP::first_slots;
 
 void SIPP::updatePath(const LLNode* goal, vector<PathEntry> &path)
 {
@@ -27,6 +30,7 @@ void SIPP::updatePath(const LLNode* goal, vector<PathEntry> &path)
 // Returns a path that minimizes the collisions with the paths in the path table, breaking ties by the length
 Path SIPP::findPath(const ConstraintTable& constraint_table)
 {
+    PROFILE_SCOPE("low-level search");
     reset();
     ReservationTable reservation_table(constraint_table, goal_location);
     Path path;
@@ -37,9 +41,10 @@ Path SIPP::findPath(const ConstraintTable& constraint_table)
     auto last_target_collision_time = constraint_table.getLastCollisionTimestep(goal_location);
     // generate start and add it to the OPEN & FOCAL list
     auto h = max(max(my_heuristic[start_location], holding_time), last_target_collision_time + 1);
-    auto start = new SIPPNode(start_location, 0, h, nullptr, 0, get<1>(interval), get<1>(interval),
-                                get<2>(interval), get<2>(interval));
-    pushNodeToFocal(start);
+    SIPPNode start(start_location, 0, h, nullptr, 0, get<1>(interval), get<1>(interval),
+                   get<2>(interval), get<2>(interval));
+    int start_slot = dominanceCheck(start);
+    pushNodeToFocal(new SIPPNode(start), start_slot);
 
     while (!focal_list.empty())
     {
@@ -65,15 +70,14 @@ Path SIPP::findPath(const ConstraintTable& constraint_table)
                 break;
             }
             // generate a goal node
-            auto goal = new SIPPNode(*curr);
-            goal->is_goal = true;
-            goal->h_val = 0;
-            goal->num_of_conflicts += future_collisions;
-            // try to retrieve it from the hash table
-            if (dominanceCheck(goal))
-                pushNodeToFocal(goal);
-            else
-                delete goal;
+            SIPPNode goal(*curr);
+            goal.is_goal = true;
+            goal.h_val = 0;
+            goal.num_of_conflicts += future_collisions;
+            // try to retrieve it from the node table
+            int slot = dominanceCheck(goal);
+            if (slot >= 0)
+                pushNodeToFocal(new SIPPNode(goal), slot);
         }
 
         for (int next_location : instance.getNeighbors(curr->location)) // move to neighboring locations
@@ -91,13 +95,12 @@ Path SIPP::findPath(const ConstraintTable& constraint_table)
                 auto next_h_val = max(my_heuristic[next_location], (next_collisions > 0?
                     holding_time : curr->getFVal()) - next_timestep); // path max
                 // generate (maybe temporary) node
-                auto next = new SIPPNode(next_location, next_timestep, next_h_val, curr, next_timestep,
-                                         next_high_generation, next_high_expansion, next_v_collision, next_collisions);
-                // try to retrieve it from the hash table
-                if (dominanceCheck(next))
-                    pushNodeToFocal(next);
-                else
-                    delete next;
+                SIPPNode next(next_location, next_timestep, next_h_val, curr, next_timestep,
+                              next_high_generation, next_high_expansion, next_v_collision, next_collisions);
+                // try to retrieve it from the node table
+                int slot = dominanceCheck(next);
+                if (slot >= 0)
+                    pushNodeToFocal(new SIPPNode(next), slot);
             }
         }  // end for loop that generates successors
         // wait at the current location
@@ -108,17 +111,17 @@ Path SIPP::findPath(const ConstraintTable& constraint_table)
             auto next_timestep = get<0>(interval);
             auto next_h_val = max(my_heuristic[curr->location], (get<2>(interval) ? holding_time : curr->getFVal()) - next_timestep); // path max
             auto next_collisions = curr->num_of_conflicts + (int)get<2>(interval);
-            auto next = new SIPPNode(curr->location, next_timestep, next_h_val, curr, next_timestep,
-                                     get<1>(interval), get<1>(interval), get<2>(interval),
-                                     next_collisions);
-            next->wait_at_goal = (curr->location == goal_location);
-            if (dominanceCheck(next))
-                pushNodeToFocal(next);
-            else
-                delete next;
+            SIPPNode next(curr->location, next_timestep, next_h_val, curr, next_timestep,
+                          get<1>(interval), get<1>(interval), get<2>(interval),
+                          next_collisions);
+            next.wait_at_goal = (curr->location == goal_location);
+            int slot = dominanceCheck(next);
+            if (slot >= 0)
+                pushNodeToFocal(new SIPPNode(next), slot);
         }
     }  // end while loop
 
+    PROFILE_COUNT("expanded nodes", num_expanded);
     releaseNodes();
     return path;
 }
@@ -134,18 +137,19 @@ Path SIPP::findOptimalPath(const HLNode& node, const ConstraintTable& initial_co
 pair<Path, int> SIPP::findSuboptimalPath(const HLNode& node, const ConstraintTable& initial_constraints,
 	const vector<Path*>& paths, int agent, int lowerbound, double w)
 {
+	PROFILE_SCOPE("low-level search");
     reset();
 	this->w = w;
 
 	// build constraint table
-    auto t = clock();
+    auto t = Time::now();
     ConstraintTable constraint_table(initial_constraints);
     constraint_table.insert2CT(node, agent);
-	runtime_build_CT = (double)(clock() - t) / CLOCKS_PER_SEC;
+	runtime_build_CT = ((fsec)(Time::now() - t)).count();
 	int holding_time = constraint_table.getHoldingTime(goal_location, constraint_table.length_min);
-	t = clock();
+	t = Time::now();
     constraint_table.insert2CAT(agent, paths);
-	runtime_build_CAT = (double)(clock() - t) / CLOCKS_PER_SEC;
+	runtime_build_CAT = ((fsec)(Time::now() - t)).count();
 
 	// build reservation table
 	ReservationTable reservation_table(constraint_table, goal_location);
@@ -158,10 +162,11 @@ pair<Path, int> SIPP::findSuboptimalPath(const HLNode& node, const ConstraintTab
 		return {path, 0};
 
 	 // generate start and add it to the OPEN list
-	auto start = new SIPPNode(start_location, 0, max(my_heuristic[start_location], holding_time), nullptr, 0,
+	SIPPNode start(start_location, 0, max(my_heuristic[start_location], holding_time), nullptr, 0,
         get<1>(interval), get<1>(interval), get<2>(interval), get<2>(interval));
-    min_f_val = max(holding_time, max((int)start->getFVal(), lowerbound));
-    pushNodeToOpenAndFocal(start);
+    min_f_val = max(holding_time, max((int)start.getFVal(), lowerbound));
+    int start_slot = dominanceCheck(start);
+    pushNodeToOpenAndFocal(new SIPPNode(start), start_slot);
 
 	while (!open_list.empty()) 
 	{
@@ -196,12 +201,11 @@ pair<Path, int> SIPP::findSuboptimalPath(const HLNode& node, const ConstraintTab
                 int next_conflicts = curr->num_of_conflicts +
                         //(int)curr->collision_v * max(next_timestep - curr->timestep - 1, 0) +
                         (int)next_v_collision + (int)next_e_collision;
-                auto next = new SIPPNode(next_location, next_g_val, next_h_val, curr, next_timestep,
+                SIPPNode next(next_location, next_g_val, next_h_val, curr, next_timestep,
                         next_high_generation, next_high_expansion, next_v_collision, next_conflicts);
-                if (dominanceCheck(next))
-                    pushNodeToOpenAndFocal(next);
-                else
-                    delete next;
+                int slot = dominanceCheck(next);
+                if (slot >= 0)
+                    pushNodeToOpenAndFocal(new SIPPNode(next), slot);
 			}
 		}  // end for loop that generates successors
 		   
@@ -213,29 +217,31 @@ pair<Path, int> SIPP::findSuboptimalPath(const HLNode& node, const ConstraintTab
 		    auto next_timestep = get<0>(interval);
             int next_h_val = max(my_heuristic[curr->location], curr->getFVal() - next_timestep);  // path max
             auto next_collisions = curr->num_of_conflicts + (int)get<2>(interval);
-            auto next = new SIPPNode(curr->location, next_timestep, next_h_val, curr, next_timestep,
-                                     get<1>(interval), get<1>(interval), get<2>(interval), next_collisions);
+            SIPPNode next(curr->location, next_timestep, next_h_val, curr, next_timestep,
+                          get<1>(interval), get<1>(interval), get<2>(interval), next_collisions);
             if (curr->location == goal_location)
-                next->wait_at_goal = true;
-            if (dominanceCheck(next))
-                pushNodeToOpenAndFocal(next);
-            else
-                delete next;
+                next.wait_at_goal = true;
+            int slot = dominanceCheck(next);
+            if (slot >= 0)
+                pushNodeToOpenAndFocal(new SIPPNode(next), slot);
 		}
 	}  // end while loop
 	  
 	  // no path found
+	PROFILE_COUNT("expanded nodes", num_expanded);
 	releaseNodes();
 	return {path, min_f_val};
 }
 
 int SIPP::getTravelTime(int start, int end, const ConstraintTable& constraint_table, int upper_bound)
 {
+    PROFILE_SCOPE("travel time query");
     reset();
     min_f_val = -1; // this disables focal list
     int length = MAX_TIMESTEP;
-    auto root = new SIPPNode(start, 0, compute_heuristic(start, end), nullptr, 0, 1, 1, 0, 0);
-    pushNodeToOpenAndFocal(root);
+    SIPPNode root(start, 0, compute_heuristic(start, end), nullptr, 0, 1, 1, 0, 0);
+    int root_slot = dominanceCheck(root);
+    pushNodeToOpenAndFocal(new SIPPNode(root), root_slot);
     auto static_timestep = constraint_table.getMaxTimestep(); // everything is static after this timestep
     while (!open_list.empty())
     {
@@ -265,12 +271,11 @@ int SIPP::getTravelTime(int start, int end, const ConstraintTable& constraint_ta
                 int next_h_val = compute_heuristic(next_location, end);
                 if (next_g_val + next_h_val >= upper_bound) // the cost of the path is larger than the upper bound
                     continue;
-                auto next = new SIPPNode(next_location, next_g_val, next_h_val, nullptr, next_timestep,
-                                         next_timestep + 1, next_timestep + 1, 0, 0);
-                if (dominanceCheck(next))
-                    pushNodeToOpenAndFocal(next);
-                else
-                    delete next;
+                SIPPNode next(next_location, next_g_val, next_h_val, nullptr, next_timestep,
+                              next_timestep + 1, next_timestep + 1, 0, 0);
+                int slot = dominanceCheck(next);
+                if (slot >= 0)
+                    pushNodeToOpenAndFocal(new SIPPNode(next), slot);
             }
         }
     }
@@ -296,19 +301,19 @@ void SIPP::updateFocalList()
 	}
 }
 
-inline void SIPP::pushNodeToOpenAndFocal(SIPPNode* node)
+inline void SIPP::pushNodeToOpenAndFocal(SIPPNode* node, int slot)
 {
     num_generated++;
 	node->open_handle = open_list.push(node);
 	node->in_openlist = true;
 	if (node->getFVal() <= w * min_f_val)
 		node->focal_handle = focal_list.push(node);
-    allNodes_table[node].push_back(node);
+    allNodes_table[slot].nodes.push_back(node);
 }
-inline void SIPP::pushNodeToFocal(SIPPNode* node)
+inline void SIPP::pushNodeToFocal(SIPPNode* node, int slot)
 {
     num_generated++;
-    allNodes_table[node].push_back(node);
+    allNodes_table[slot].nodes.push_back(node);
     node->in_openlist = true;
     node->focal_handle = focal_list.push(node); // we only use focal list; no open list is used
 }
@@ -333,9 +338,12 @@ void SIPP::releaseNodes()
 {
     open_list.clear();
     focal_list.clear();
-    for (auto & node_list : allNodes_table)
-        for (auto n : node_list.second)
+    for (auto & slot : allNodes_table)
+    {
+        for (auto n : slot.nodes)
             delete n;
+        first_slots[slot.location] = -1;
+    }
     allNodes_table.clear();
     for (auto n : useless_nodes)
         delete n;
@@ -345,9 +353,9 @@ void SIPP::releaseNodes()
 void SIPP::printSearchTree() const
 {
     vector<list<SIPPNode*>> nodes;
-    for (const auto & node_list : allNodes_table)
+    for (const auto & slot : allNodes_table)
     {
-        for (const auto & n : node_list.second)
+        for (const auto & n : slot.nodes)
         {
             if (nodes.size() <= n->timestep)
                 nodes.resize(n->timestep + 1);
@@ -364,44 +372,56 @@ void SIPP::printSearchTree() const
     }
 }
 
-// return true iff we the new node is not dominated by any old node
-bool SIPP::dominanceCheck(SIPPNode* new_node)
+// return the slot of the new node if it is not dominated by any old node, and -1 otherwise
+int SIPP::dominanceCheck(SIPPNode& new_node)
 {
-    auto ptr = allNodes_table.find(new_node);
-    if (ptr == allNodes_table.end())
-        return true;
-    for (auto & old_node : ptr->second)
+    if ((int)first_slots.size() < instance.map_size)
+        first_slots.resize(instance.map_size, -1);
+    int slot = first_slots[new_node.location];
+    while (slot >= 0 and (allNodes_table[slot].high_generation != new_node.high_generation or
+                          allNodes_table[slot].wait_at_goal != new_node.wait_at_goal or
+                          allNodes_table[slot].is_goal != new_node.is_goal))
+        slot = allNodes_table[slot].next;
+    if (slot < 0)
+    {
+        allNodes_table.emplace_back(new_node, first_slots[new_node.location]);
+        first_slots[new_node.location] = (int)allNodes_table.size() - 1;
+        return first_slots[new_node.location];
+    }
+    auto& nodes = allNodes_table[slot].nodes;
+    for (auto it = nodes.begin(); it != nodes.end(); ++it)
     {
-        if (old_node->timestep <= new_node->timestep and
-            old_node->num_of_conflicts <= new_node->num_of_conflicts)
+        auto old_node = *it;
+        if (old_node->timestep <= new_node.timestep and
+            old_node->num_of_conflicts <= new_node.num_of_conflicts)
         { // the new node is dominated by the old node
-            return false;
+            return -1;
         }
-        else if (old_node->timestep >= new_node->timestep and
-                old_node->num_of_conflicts >= new_node->num_of_conflicts) // the old node is dominated by the new node
+        else if (old_node->timestep >= new_node.timestep and
+                old_node->num_of_conflicts >= new_node.num_of_conflicts) // the old node is dominated by the new node
         { // delete the old node
             if (old_node->in_openlist) // the old node has not been expanded yet
                 eraseNodeFromLists(old_node); // delete it from open and/or focal lists
             else // the old node has been expanded already
                 num_reopened++; //re-expand it
             useless_nodes.push_back(old_node);
-            ptr->second.remove(old_node);
+            nodes.erase(it);
             num_generated--; // this is because we later will increase num_generated when we insert the new node into lists.
-            return true;
+            return slot;
         }
-        else if(old_node->timestep < new_node->high_expansion and new_node->timestep < old_node->high_expansion)
+        else if(old_node->timestep < new_node.high_expansion and new_node.timestep < old_node->high_expansion)
         { // intervals overlap --> we need to split the node to make them disjoint
-            if (old_node->timestep <= new_node->timestep)
+            if (old_node->timestep <= new_node.timestep)
             {
-                assert(old_node->num_of_conflicts > new_node->num_of_conflicts);
-                old_node->high_expansion = new_node->timestep;
+                assert(old_node->num_of_conflicts > new_node.num_of_conflicts);
+                old_node->high_expansion = new_node.timestep;
             }
-            else // i.e., old_node->timestep > new_node->timestep
+            else // i.e., old_node->timestep > new_node.timestep
             {
-                assert(old_node->num_of_conflicts <= new_node->num_of_conflicts);
-                new_node->high_expansion = old_node->timestep;
+                assert(old_node->num_of_conflicts <= new_node.num_of_conflicts);
+                new_node.high_expansion = old_node->timestep;
             }
         }
     }
-    return true;
+    return slot;
 }
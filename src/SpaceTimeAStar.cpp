@@ -1,4 +1,5 @@
 #include "SpaceTimeAStar.h"
+#include "Profiler.h"
 
 
 void SpaceTimeAStar::updatePath(const LLNode* goal, vector<PathEntry> &path)
@@ -27,6 +28,7 @@ Path SpaceTimeAStar::findOptimalPath(const HLNode& node, const ConstraintTable&
 // Returns a path that minimizes the collisions with the paths in the path table, breaking ties by the length
 Path SpaceTimeAStar::findPath(const ConstraintTable& constraint_table)
 {
+    PROFILE_SCOPE("low-level search");
     reset();
     Path path;
     if (constraint_table.constrained(start_location, 0))
@@ -170,6 +172,7 @@ Path SpaceTimeAStar::findPath(const ConstraintTable& constraint_table)
         }  // end for loop that generates successors
     }  // end while loop
 
+    PROFILE_COUNT("expanded nodes", num_expanded);
     releaseNodes();
     return path;
 }
@@ -181,23 +184,24 @@ Path SpaceTimeAStar::findPath(const ConstraintTable& constraint_table)
 pair<Path, int> SpaceTimeAStar::findSuboptimalPath(const HLNode& node, const ConstraintTable& initial_constraints,
 	const vector<Path*>& paths, int agent, int lowerbound, double w)
 {
+	PROFILE_SCOPE("low-level search");
     reset();
 	this->w = w;
 	Path path;
 
 	// build constraint table
-	auto t = clock();
+	auto t = Time::now();
     ConstraintTable constraint_table(initial_constraints);
     constraint_table.insert2CT(node, agent);
-	runtime_build_CT = (double)(clock() - t) / CLOCKS_PER_SEC;
+	runtime_build_CT = ((fsec)(Time::now() - t)).count();
 	if (constraint_table.constrained(start_location, 0))
 	{
 		return {path, 0};
 	}
 
-	t = clock();
+	t = Time::now();
     constraint_table.insert2CAT(agent, paths);
-	runtime_build_CAT = (double)(clock() - t) / CLOCKS_PER_SEC;
+	runtime_build_CAT = ((fsec)(Time::now() - t)).count();
 
 	// the earliest timestep that the agent can hold its goal location. The length_min is considered here.
     auto holding_time = constraint_table.getHoldingTime(goal_location, constraint_table.length_min);
@@ -313,6 +317,7 @@ pair<Path, int> SpaceTimeAStar::findSuboptimalPath(const HLNode& node, const Con
 		}  // end for loop that generates successors
 	}  // end while loop
 
+	PROFILE_COUNT("expanded nodes", num_expanded);
 	releaseNodes();
 	return {path, min_f_val};
 }
@@ -320,6 +325,7 @@ pair<Path, int> SpaceTimeAStar::findSuboptimalPath(const HLNode& node, const Con
 
 int SpaceTimeAStar::getTravelTime(int start, int end, const ConstraintTable& constraint_table, int upper_bound)
 {
+    PROFILE_SCOPE("travel time query");
     reset();
 	int length = MAX_TIMESTEP;
     auto static_timestep = constraint_table.getMaxTimestep() + 1; // everything is static after this timestep
@@ -20,4 +20,11 @@ bool isSamePath(const Path& p1, const Path& p2)
 			return false;
 	}
 	return true;
-}
\ No newline at end of file
+}
+
+
+std::mt19937& threadRandomEngine()
+{
+	thread_local std::mt19937 engine;
+	return engine;
+}
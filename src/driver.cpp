@@ -4,6 +4,7 @@
 #include "AnytimeBCBS.h"
 #include "AnytimeEECBS.h"
 #include "PIBT/pibt.h"
+#include "Profiler.h"
 
 
 /* Main function */
@@ -16,6 +17,8 @@ int main(int argc, char** argv)
 		("help", "produce help message")
 
         ("state", po::value<string>()->default_value(""), "json file that stores the state")
+        ("instanceCache", po::value<string>()->default_value(""),
+         "directory of the binary cache of parsed maps and scens (empty for no cache)")
 		// params for the input instance and experiment settings
         ("log_step", po::value<int>()->default_value(1), "number of agents")
 		("map,m", po::value<string>()->required(), "input file for map")
@@ -28,11 +31,14 @@ int main(int argc, char** argv)
 		("screen,s", po::value<int>()->default_value(0),
 		        "screen option (0: none; 1: LNS results; 2:LNS detailed results; 3:MAPF detailed results)")
 		("stats", po::value<string>(), "output stats file")
+		("profile", po::value<string>(), "output file for the wall-clock profile of the run (JSON)")
         ("banditAlgo", po::value<string>()->default_value("Random"), "Bandit algorithm for Adaptive LNS (Random, Roulette, UCB1, Thompson)")
 
 		// solver
 		("solver", po::value<string>()->default_value("LNS"), "solver (LNS, A-BCBS, A-EECBS)")
 		("sipp", po::value<bool>()->default_value(true), "Use SIPP as the single-agent solver")
+		("compactHeuristics", po::value<bool>()->default_value(false),
+		        "store the heuristic tables as 16-bit distances that are only computed as far as they are queried")
 		("seed", po::value<int>()->default_value(0), "Random seed")
 
         // params for LNS
@@ -44,8 +50,26 @@ int main(int argc, char** argv)
         ("maxIterations", po::value<int>()->default_value(0), "maximum number of iterations")
         ("initAlgo", po::value<string>()->default_value("PP"),
                 "MAPF algorithm for finding the initial solution (EECBS, PP, PPS, CBS, PIBT, winPIBT)")
+        ("initPortfolio", po::value<string>()->default_value(""),
+                "comma-separated initial solvers raced in parallel, e.g., PP,PP,PIBT,EECBS (overrides initAlgo)")
+        ("portfolioGrace", po::value<double>()->default_value(0),
+                "seconds to wait for cheaper portfolio solutions after the first one is found")
+        ("goalStream", po::value<string>()->default_value(""),
+                "file of new goals as \"row col\" pairs; runs LNS in rolling-horizon lifelong mode if not empty")
+        ("horizon", po::value<int>()->default_value(5), "number of timesteps committed per tick in lifelong mode")
+        ("tickTime", po::value<double>()->default_value(1), "seconds of LNS improvement per tick in lifelong mode")
+        ("ticks", po::value<int>()->default_value(0),
+                "number of ticks in lifelong mode (0: until all goals in the stream are reached)")
+        ("window", po::value<int>()->default_value(0),
+                "ignore collisions after this many timesteps (0: no window); meant for lifelong mode")
+        ("checkpoint", po::value<string>()->default_value(""),
+                "binary file of the checkpoints of the LNS search state (empty for none)")
+        ("checkpointInterval", po::value<double>()->default_value(0),
+                "seconds between checkpoints (0: only at the end of the run)")
+        ("resume", po::value<bool>()->default_value(false), "resume from the checkpoint if it exists")
         ("replanAlgo", po::value<string>()->default_value("PP"),
-                "MAPF algorithm for replanning (EECBS, CBS, PP)")
+                "MAPF algorithm for replanning (EECBS, CBS, PP, PIBT, winPIBT, "
+                "Adaptive: the bandit chooses among PP, PIBT and winPIBT)")
         ("pibtWindow", po::value<int>()->default_value(5),
              "window size for winPIBT")
         ("winPibtSoftmode", po::value<bool>()->default_value(true),
@@ -66,16 +90,19 @@ int main(int argc, char** argv)
     PIBTPPS_option pipp_option;
     pipp_option.windowSize = vm["pibtWindow"].as<int>();
     pipp_option.winPIBTSoft = vm["winPibtSoftmode"].as<bool>();
+    pipp_option.timestepLimit = 0; // no limit
 
     po::notify(vm);
 
-	srand((int)time(0));
+	threadRandomEngine().seed(vm["seed"].as<int>()); // also used when generating random instances
+	if (vm.count("profile"))
+		Profiler::enable();
 
     Instance instance(vm["map"].as<string>(), vm["agents"].as<string>(), vm["state"].as<string>(),
-		vm["agentNum"].as<int>());
+		vm["agentNum"].as<int>(), 0, 0, 0, 0, vm["instanceCache"].as<string>());
+    instance.compact_heuristics = vm["compactHeuristics"].as<bool>();
     double time_limit = vm["cutoffTime"].as<double>();
     int screen = vm["screen"].as<int>();
-	srand(vm["seed"].as<int>());
 
 	if (vm["solver"].as<string>() == "LNS")
     {
@@ -89,11 +116,25 @@ int main(int argc, char** argv)
                 vm["initDestroyStrategy"].as<string>(),
                 vm["sipp"].as<bool>(),
                 screen, pipp_option, vm["banditAlgo"].as<string>(), vm["neighborCandidateSizes"].as<int>());
+        lns.setSeed(vm["seed"].as<int>());
         lns.uniform_neighbor = vm["uniform_neighbor"].as<int>();
         lns.replan_time_limit = vm["replanTime"].as<double>();
         lns.state_json = vm["state"].as<string>();
         lns.log_step = vm["log_step"].as<int>();
-        bool succ = lns.run();
+        boost::char_separator<char> sep(",");
+        boost::tokenizer<boost::char_separator<char>> portfolio(vm["initPortfolio"].as<string>(), sep);
+        lns.init_portfolio.assign(portfolio.begin(), portfolio.end());
+        lns.portfolio_grace = vm["portfolioGrace"].as<double>();
+        lns.goal_stream = vm["goalStream"].as<string>();
+        lns.horizon = vm["horizon"].as<int>();
+        lns.tick_time = vm["tickTime"].as<double>();
+        lns.num_of_ticks = vm["ticks"].as<int>();
+        if (vm["window"].as<int>() > 0)
+            lns.window = vm["window"].as<int>();
+        lns.checkpoint_file = vm["checkpoint"].as<string>();
+        lns.checkpoint_interval = vm["checkpointInterval"].as<double>();
+        lns.resume = vm["resume"].as<bool>();
+        bool succ = lns.goal_stream.empty() ? lns.run() : lns.runLifelong();
         if (succ)
         {
             lns.validateSolution();
@@ -130,6 +171,8 @@ int main(int argc, char** argv)
 	    cerr << "Solver " << vm["solver"].as<string>() << " does not exist!" << endl;
 	    exit(-1);
     }
+	if (vm.count("profile"))
+		Profiler::write(vm["profile"].as<string>());
 	return 0;
 
 }